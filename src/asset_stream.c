@@ -0,0 +1,125 @@
+// ---------------------------------------------------------------------------
+// asset_stream.c
+//
+// Double-buffered sequential reader for files on the USB drive.
+// ---------------------------------------------------------------------------
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "asset_stream.h"
+
+// ---------------------------------------------------------------------------
+// Load the next chunk of the file into buffer index. A file only reads
+// short at its end, so a short chunk is the last one and reaching the
+// end does not take another read.
+// ---------------------------------------------------------------------------
+static void load(asset_stream_t *stream, uint8_t index)
+{
+    int count = 0;
+
+    if (!stream->eof) {
+        count = read(stream->fd, stream->chunk[index], ASSET_CHUNK_BYTES);
+        if (count < ASSET_CHUNK_BYTES) {
+            stream->eof = true;
+        }
+        if (count < 0) {
+            count = 0;
+        }
+    }
+    stream->length[index] = count;
+    stream->bytes_loaded += count;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool asset_stream_open(asset_stream_t *stream, const char *path)
+{
+    stream->fd = open(path, O_RDONLY);
+    if (stream->fd < 0) {
+        return false;
+    }
+    stream->bytes_loaded = 0;
+    stream->bytes_read = 0;
+    stream->stalls = 0;
+    return asset_stream_seek(stream, 0);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void asset_stream_close(asset_stream_t *stream)
+{
+    if (stream->fd >= 0) {
+        close(stream->fd);
+        stream->fd = -1;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool asset_stream_seek(asset_stream_t *stream, uint32_t offset)
+{
+    if (lseek(stream->fd, offset, SEEK_SET) < 0) {
+        return false;
+    }
+    stream->eof = false;
+    stream->current = 0;
+    stream->pos = 0;
+    stream->length[1] = 0;
+    load(stream, 0);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool asset_stream_prefetch(asset_stream_t *stream)
+{
+    uint8_t spare = stream->current ^ 1;
+
+    if (stream->length[spare] == 0 && !stream->eof) {
+        load(stream, spare);
+    }
+    return stream->length[spare] != 0 || stream->eof;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint16_t asset_stream_read(asset_stream_t *stream, void *dst, uint16_t bytes)
+{
+    uint8_t *out = (uint8_t *)dst;
+    uint16_t done = 0;
+
+    while (done < bytes) {
+        uint8_t current = stream->current;
+        uint16_t count = stream->length[current] - stream->pos;
+
+        if (count == 0) {
+            // current chunk used up, move on to the spare one
+            uint8_t spare = current ^ 1;
+            if (stream->length[spare] == 0) {
+                if (stream->eof) {
+                    break;
+                }
+                stream->stalls++;
+                load(stream, spare);
+                if (stream->length[spare] == 0) {
+                    break;
+                }
+            }
+            stream->length[current] = 0;
+            stream->current = spare;
+            stream->pos = 0;
+            continue;
+        }
+        if (count > bytes - done) {
+            count = bytes - done;
+        }
+        memcpy(out + done, stream->chunk[current] + stream->pos, count);
+        stream->pos += count;
+        done += count;
+    }
+    stream->bytes_read += done;
+    return done;
+}
@@ -0,0 +1,50 @@
+// ---------------------------------------------------------------------------
+// asset_stream.h
+//
+// Sequential reader for asset files on the USB drive, for data that does
+// not fit in RAM at once (long pose animations, large meshes).
+//
+// The file is read in fixed-size chunks into two buffers: while one is
+// consumed, the other one holds the next chunk. asset_stream_prefetch()
+// loads that spare chunk and is meant to be called once per frame (or as
+// a background job), so reads of the following frame are served from
+// RAM. A read that runs into a chunk that is not loaded yet has to load
+// it on the spot: that is a stall.
+//
+// Only open(), read(), lseek() and close() are used, so the same code
+// builds on a POSIX host for testing.
+// ---------------------------------------------------------------------------
+
+#ifndef ASSET_STREAM_H
+#define ASSET_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ASSET_CHUNK_BYTES 512
+
+typedef struct {
+    int      fd;
+    uint8_t  chunk[2][ASSET_CHUNK_BYTES];
+    uint16_t length[2];     // valid bytes, 0 when not loaded
+    uint8_t  current;       // chunk being consumed
+    uint16_t pos;           // read position in the current chunk
+    bool     eof;           // no more chunks to load
+    uint32_t bytes_loaded;  // from the file
+    uint32_t bytes_read;    // by the consumer
+    uint16_t stalls;        // reads that had to wait for a load
+} asset_stream_t;
+
+// Open path and load the first chunk. Returns false if it can not be read.
+bool asset_stream_open(asset_stream_t *stream, const char *path);
+void asset_stream_close(asset_stream_t *stream);
+// Go back to byte offset of the file (to loop an animation)
+bool asset_stream_seek(asset_stream_t *stream, uint32_t offset);
+// Load the spare chunk if it is empty. Returns true when there is nothing
+// left to do, so it can run as a background job.
+bool asset_stream_prefetch(asset_stream_t *stream);
+// Copy the next bytes into dst. Returns the count copied, less than bytes
+// only at the end of the file.
+uint16_t asset_stream_read(asset_stream_t *stream, void *dst, uint16_t bytes);
+
+#endif // ASSET_STREAM_H
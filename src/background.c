@@ -0,0 +1,62 @@
+// ---------------------------------------------------------------------------
+// background.c
+//
+// Cooperative background work for idle time.
+// ---------------------------------------------------------------------------
+
+#include <rp6502.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "background.h"
+
+static background_job_t jobs[BACKGROUND_MAX_JOBS];
+static uint8_t job_count = 0;
+static uint8_t next_job = 0;
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool background_add(background_job_t job)
+{
+    uint8_t i;
+
+    for (i = 0; i < job_count; i++) {
+        if (jobs[i] == job) {
+            return true;
+        }
+    }
+    if (job_count >= BACKGROUND_MAX_JOBS) {
+        return false;
+    }
+    jobs[job_count++] = job;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool background_pending(void)
+{
+    return job_count > 0;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void background_run(void)
+{
+    uint8_t vsync = RIA.vsync;
+    uint8_t i;
+
+    while (job_count > 0 && RIA.vsync == vsync) {
+        if (next_job >= job_count) {
+            next_job = 0;
+        }
+        if (jobs[next_job]()) {
+            // finished, close the gap
+            job_count--;
+            for (i = next_job; i < job_count; i++) {
+                jobs[i] = jobs[i + 1];
+            }
+        } else {
+            next_job++;
+        }
+    }
+}
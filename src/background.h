@@ -0,0 +1,30 @@
+// ---------------------------------------------------------------------------
+// background.h
+//
+// Cooperative background work for idle time (title screen, pause).
+//
+// A job is a function that does one small slice of work per call and
+// keeps its own progress, returning true once it has finished. Idle loops
+// call background_run() between input polls; it hands out slices until
+// the next vsync, so input stays responsive and every job picks up where
+// it stopped.
+// ---------------------------------------------------------------------------
+
+#ifndef BACKGROUND_H
+#define BACKGROUND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BACKGROUND_MAX_JOBS 4
+
+typedef bool (*background_job_t)(void);
+
+// Queue a job (a job that is already queued is not added twice)
+bool background_add(background_job_t job);
+// True while any job is queued
+bool background_pending(void);
+// Run job slices round-robin until the next vsync tick
+void background_run(void);
+
+#endif // BACKGROUND_H
@@ -1,644 +1,1904 @@
-// ---------------------------------------------------------------------------
-// bitmap_graphics_db.c
-//
-// This library was written by tonyvr
-// and upgraded by WojciechGw for double buffering 
-// to simplify bitmap graphics programming
-// of the RP6502 picocomputer designed by Rumbledethumps.
-//
-// This code is an adaptation of the vga_graphics library written by V. Hunter Adams
-// from Cornell University, for his excellent RP2040 microcontroller programming course.
-//
-// https://github.com/vha3/Hunter-Adams-RP2040-Demos/tree/master/VGA_Graphics/VGA_Graphics_Primitives
-//
-// There doesn't seem to be a copyright or a license associated with his code.
-// I don't care what you do with my version either -- have fun!
-// ---------------------------------------------------------------------------
-
-#include <rp6502.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <stdbool.h>
-#include <stdint.h>
-#include "font5x7.h"
-#include "colors.h"
-#include "bitmap_graphics_db.h"
-
-// For drawing lines
-// defaults
-static uint16_t canvas_struct = 0xFF00;
-static uint16_t canvas_data = 0x0000;
-static uint8_t  plane = 0;
-static uint8_t  canvas_mode = 2;
-static uint16_t canvas_w = 320;
-static uint16_t canvas_h = 180;
-static uint8_t  bpp_mode = 3;
-static uint8_t  bpp = 4;
-
-// For drawing characters
-// defaults
-static uint16_t cursor_y = 0;
-static uint16_t cursor_x = 0;
-static uint8_t textmultiplier = 1;
-static uint16_t textcolor = 15;
-static uint16_t textbgcolor = 15;
-static bool wrap = true;
-
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
-static uint8_t bpp_mode_to_bpp[] = {1, 2, 4, 8, 16};
-static uint8_t bbp_to_bpp_mode(uint8_t bpp)
-{
-    switch(bpp) {
-        case 1:  return 0;
-        case 2:  return 1;
-        case 4:  return 2;
-        case 8:  return 3;
-        case 16: return 4;
-    }
-    return 2; // default
-}
-
-void init_bitmap_graphics(uint16_t canvas_struct_address,
-                          uint16_t canvas_data_address,
-                          uint8_t  canvas_plane,
-                          uint8_t  canvas_type,
-                          uint16_t canvas_width,
-                          uint16_t canvas_height,
-                          uint8_t  bits_per_pixel)
-{
-    uint8_t x_offset = 0;
-    uint8_t y_offset = 0;
-
-    // defaults
-    canvas_struct = 0xFF00;
-    canvas_data = 0x0000;
-    plane = 0;
-    canvas_mode = 2;
-    canvas_w = 320;
-    canvas_h = 180;
-    bpp_mode = 3;
-
-    // valid range check
-    if (canvas_struct_address != 0) {
-        canvas_struct = canvas_struct_address;
-    }
-    if (canvas_data_address != 0) {
-        canvas_data = canvas_data_address;
-    }
-    if (/*canvas_plane >= 0 &&*/ canvas_plane <= 2) {
-        plane = canvas_plane;
-    }
-    if (canvas_type > 0 && canvas_type <= 4) {
-        canvas_mode = canvas_type;
-    }
-    if (canvas_width > 0 && canvas_width <= 640) {
-        canvas_w = canvas_width;
-    }
-    if (canvas_height > 0 && canvas_height <= 480) {
-        canvas_h = canvas_height;
-    }
-    if (bits_per_pixel == 1 ||
-        bits_per_pixel == 2 ||
-        bits_per_pixel == 4 ||
-        bits_per_pixel == 8 ||
-        bits_per_pixel == 16  ) {
-        bpp_mode = bbp_to_bpp_mode(bits_per_pixel);
-    }
-
-    // additional contraints (due to memory limit of 64K)
-    if (bpp_mode_to_bpp[bpp_mode] == 16) { // bits color
-        canvas_mode = 2;
-        canvas_w = 240; // max for 16-bit color
-        canvas_h = 124; // max for 16-bit color
-    } else if (bpp_mode_to_bpp[bpp_mode] == 8) { // bits color
-        canvas_mode = 2;
-        canvas_w = 240; // max for 8-bit color
-        canvas_h = 124; // max for 8-bit color
-    } else if (bpp_mode_to_bpp[bpp_mode] == 4) { // bits color
-        canvas_w = 320; // max for 4-bit color
-        if (canvas_mode > 2) {
-            canvas_mode = 1;
-            canvas_h = 240; // max for 4-bit color
-        } else if (canvas_mode == 2) {
-            canvas_h = 180; // max for canvas_mode 2
-        }
-    } else if (bpp_mode_to_bpp[bpp_mode] == 2) { // bits color
-        if (canvas_mode == 4) {
-            canvas_h = 360; // max for canvas_mode 4
-        }
-    }
-
-    // center canvas if necessary
-    if (bpp_mode_to_bpp[bpp_mode] == 16) {
-        x_offset = 30; // (360 - 240)/4
-        y_offset = 29; // (240 - 124)/4
-    }
-
-    if (canvas_struct_address != canvas_struct) {
-        printf("Asked for canvas_struct_address of 0x%04X, but got 0x%04X\n", canvas_struct_address, canvas_struct);
-    }
-    if (canvas_data_address != canvas_data) {
-        printf("Asked for canvas_data_address of 0x%04X, but got 0x%04X\n", canvas_struct_address, canvas_data);
-    }
-    if (canvas_type != canvas_mode) {
-        printf("Asked for canvas_type of %u, but got %u\n", canvas_type, canvas_mode);
-    }
-    if (canvas_width != canvas_w) {
-        printf("Asked for canvas_width of %u, but got %u\n", canvas_width, canvas_w);
-    }
-    if (canvas_height != canvas_h) {
-        printf("Asked for canvas_height of %u, but got %u\n", canvas_height, canvas_h);
-    }
-    if (bits_per_pixel != bpp_mode_to_bpp[bpp_mode]) {
-        printf("Asked for bits_per_pixel of %u, but got %u\n", bits_per_pixel, bpp_mode_to_bpp[bpp_mode]);
-    }
-
-    //initialize the canvas
-    //xreg_vga_canvas(canvas_mode);
-    xregn(1, 0, 0, 1, canvas_mode);
-
-    xram0_struct_set(canvas_struct, vga_mode3_config_t, x_wrap, false);
-    xram0_struct_set(canvas_struct, vga_mode3_config_t, y_wrap, false);
-    xram0_struct_set(canvas_struct, vga_mode3_config_t, x_pos_px, x_offset);
-    xram0_struct_set(canvas_struct, vga_mode3_config_t, y_pos_px, y_offset);
-    xram0_struct_set(canvas_struct, vga_mode3_config_t, width_px, canvas_w);
-    xram0_struct_set(canvas_struct, vga_mode3_config_t, height_px, canvas_h);
-    xram0_struct_set(canvas_struct, vga_mode3_config_t, xram_data_ptr, canvas_data);
-    xram0_struct_set(canvas_struct, vga_mode3_config_t, xram_palette_ptr, 0xFFFF);
-
-    // initialize the bitmap video modes
-    //xreg_vga_mode(3, bpp_mode, canvas_struct, plane); // bitmap mode
-    xregn(1, 0, 1, 4, 3, bpp_mode, canvas_struct, plane);
-
-    printf("canvas_mode: %i, bpp_mode: %i, canvas_struct: %i, plane: %i\n", canvas_mode, bpp_mode, plane);
-    printf("canvas_w: %i, canvas_h: %i\n", canvas_w, canvas_h);
-
-    //xreg_vga_mode(0, 1); // console
-}
-
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
-uint16_t canvas_width(void)
-{
-    return canvas_w;
-}
-
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
-uint16_t canvas_height(void)
-{
-    return canvas_h;
-}
-
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
-uint8_t bits_per_pixel(void)
-{
-    return bpp_mode_to_bpp[bpp_mode];
-}
-
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
-uint16_t random(uint16_t low_limit, uint16_t high_limit)
-{
-    if (low_limit > high_limit) {
-        swap(low_limit, high_limit);
-    }
-
-    return (uint16_t)((rand() % (high_limit-low_limit)) + low_limit);
-}
-
-// ---------------------------------------------------------------------------
-// Set cursor for text to be printed
-// ---------------------------------------------------------------------------
-void set_cursor(uint16_t x, uint16_t y)
-{
-    cursor_x = x;
-    cursor_y = y;
-}
-
-// ---------------------------------------------------------------------------
-// Set multiplier of text to be displayed (1 for 5x7, 2 for 10x14, etc...)
-// ---------------------------------------------------------------------------
-void set_text_multiplier(uint8_t mult)
-{
-    textmultiplier = (mult > 0) ? mult : 1;
-}
-
-// ---------------------------------------------------------------------------
-// Set colors of text to be displayed.
-//     For 'transparent' background, we'll set the bg
-//     to the same as fg instead of using a flag
-// ---------------------------------------------------------------------------
-void set_text_color(uint16_t color)
-{
-    textcolor = textbgcolor = color;
-}
-
-// ---------------------------------------------------------------------------
-// Set colors of text to be displayed
-//      color = color of text
-//      background = color of text background
-// ---------------------------------------------------------------------------
-void set_text_colors(uint16_t color, uint16_t background)
-{
-    textcolor   = color;
-    textbgcolor = background;
-}
-
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
-void set_text_wrap(bool w)
-{
-    wrap = w;
-}
-
-void switch_buffer(uint16_t buffer_data_address)
-{
-    xram0_struct_set(canvas_struct, vga_mode3_config_t, xram_data_ptr, buffer_data_address);
-}
-
-void erase_buffer(uint16_t buffer_data_address)
-{
-    uint16_t i, num_bytes;
-
-    if (bpp_mode == 4) { // 16bpp
-        num_bytes = (canvas_w<<1) * canvas_h;
-    } else if (bpp_mode == 3) { // 8bpp
-        num_bytes = canvas_w * canvas_h;
-    } else if (bpp_mode == 2) { // 4bpp
-        num_bytes = (canvas_w>>1) * canvas_h;
-    } else if (bpp_mode == 1) { //2bpp
-        num_bytes = (canvas_w>>2) * canvas_h;
-    } else if (bpp_mode == 0) { //1bpp
-        num_bytes = (canvas_w>>3) * canvas_h;
-    }
-
-    RIA.addr0 = buffer_data_address;
-    RIA.step0 = 1;
-    for (i = 0; i < (num_bytes/16); i++) {
-        // unrolled for speed
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-        RIA.rw0 = 0;
-    }
-}
-
-void draw_pixel2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t buffer_data_address)
-{
-    if (bpp_mode == 4) { // 16bpp
-        RIA.addr0 = buffer_data_address + (canvas_w * 2 * y + x * 2);
-        RIA.step0 = 1;
-        RIA.rw0 = color;
-        RIA.rw0 = color >> 8;
-    } else if (bpp_mode == 3) { // 8bpp
-        RIA.addr0 = buffer_data_address + (canvas_w * y + x);
-        RIA.step0 = 1;
-        RIA.rw0 = color;
-    } else if (bpp_mode == 2) { // 4bpp
-        uint8_t shift = 4 * (1 - (x & 1));
-        RIA.addr0 = buffer_data_address + (canvas_w / 2 * y + x / 2);
-        RIA.step0 = 0;
-        RIA.rw0 = (RIA.rw0 & ~(15 << shift)) | ((color & 15) << shift);
-    } else if (bpp_mode == 1) { // 2bpp
-        uint8_t shift = 2 * (3 - (x & 3));
-        RIA.addr0 = buffer_data_address + (canvas_w / 4 * y + x / 4);
-        RIA.step0 = 0;
-        if (color > 0 && (color % 4) == 0) {
-            color = 1; // avoid 'accidental' black
-        }
-        RIA.rw0 = (RIA.rw0 & ~(3 << shift)) | ((color & 3) << shift);
-    } else if (bpp_mode == 0) { // 1bpp
-        uint8_t shift = 1 * (7 - (x & 7));
-        RIA.addr0 = buffer_data_address + (canvas_w / 8 * y + x / 8);
-        RIA.step0 = 0;
-        color = (color != 0) ? 1 : 0;
-        RIA.rw0 = (RIA.rw0 & ~(1 << shift)) | ((color & 1) << shift);
-    }
-}
-
-void draw_line2buffer(uint16_t color, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t buffer_data_address)
-{
-    int16_t dx, dy;
-    int16_t err;
-    int16_t ystep;
-    int16_t steep = abs(y1 - y0) > abs(x1 - x0);
-
-    if (steep) {
-        swap(x0, y0);
-        swap(x1, y1);
-    }
-
-    if (x0 > x1) {
-        swap(x0, x1);
-        swap(y0, y1);
-    }
-
-    dx = x1 - x0;
-    dy = abs(y1 - y0);
-
-    err = dx / 2;
-
-    if (y0 < y1) {
-        ystep = 1;
-    } else {
-        ystep = -1;
-    }
-
-    for (; x0<=x1; x0++) {
-        if (steep) {
-            draw_pixel2buffer(color, y0, x0, buffer_data_address);
-        } else {
-            draw_pixel2buffer(color, x0, y0, buffer_data_address);
-        }
-
-        err -= dy;
-
-        if (err < 0) {
-            y0 += ystep;
-            err += dx;
-        }
-    }
-}
-
-void draw_vline2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t h, uint16_t buffer_data_address)
-{
-    uint16_t i;
-    for (i=y; i<(y+h); i++) {
-        draw_pixel2buffer(color, x, i, buffer_data_address);
-    }
-}
-
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
-void draw_hline2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t buffer_data_address)
-{
-    uint16_t i;
-    for (i=x; i<(x+w); i++) {
-        draw_pixel2buffer(color, i, y, buffer_data_address);
-    }
-}
-
-void draw_rect2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t buffer_data_address)
-{
-    draw_hline2buffer(color, x, y, w, buffer_data_address);
-    draw_hline2buffer(color, x, y+h-1, w, buffer_data_address);
-    draw_vline2buffer(color, x, y, h, buffer_data_address);
-    draw_vline2buffer(color, x+w-1, y, h, buffer_data_address);
-}
-
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
-void fill_rect2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t buffer_data_address)
-{
-    uint16_t i, j;
-    for(i=x; i<(x+w); i++) {
-        for(j=y; j<(y+h); j++) {
-            draw_pixel2buffer(color, i, j, buffer_data_address);
-        }
-    }
-}
-
-// ---------------------------------------------------------------------------
-// This seems to draw circle quadrants
-// ---------------------------------------------------------------------------
-static void draw_circle_helper2buffer(uint16_t color,
-                               uint16_t x0, uint16_t y0, uint16_t r,
-                               uint8_t cornername, uint16_t buffer_data_address)
-{
-    int16_t f     = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t x     = 0;
-    int16_t y     = r;
-
-    while (x<y) {
-        if (f >= 0) {
-            y--;
-            ddF_y += 2;
-            f     += ddF_y;
-        }
-
-        x++;
-        ddF_x += 2;
-        f     += ddF_x;
-
-        if (cornername & 0x4) {
-            draw_pixel2buffer(color, x0 + x, y0 + y, buffer_data_address);
-            draw_pixel2buffer(color, x0 + y, y0 + x, buffer_data_address);
-        }
-        if (cornername & 0x2) {
-            draw_pixel2buffer(color, x0 + x, y0 - y, buffer_data_address);
-            draw_pixel2buffer(color, x0 + y, y0 - x, buffer_data_address);
-        }
-        if (cornername & 0x8) {
-            draw_pixel2buffer(color, x0 - y, y0 + x, buffer_data_address);
-            draw_pixel2buffer(color, x0 - x, y0 + y, buffer_data_address);
-        }
-        if (cornername & 0x1) {
-            draw_pixel2buffer(color, x0 - y, y0 - x, buffer_data_address);
-            draw_pixel2buffer(color, x0 - x, y0 - y, buffer_data_address);
-        }
-    }
-}
-
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
-void draw_circle2buffer(uint16_t color, uint16_t x0, uint16_t y0, uint16_t r, uint16_t buffer_data_address)
-{
-    int16_t f = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t x = 0;
-    int16_t y = r;
-
-    draw_pixel2buffer(color, x0  , y0+r, buffer_data_address);
-    draw_pixel2buffer(color, x0  , y0-r, buffer_data_address);
-    draw_pixel2buffer(color, x0+r, y0  , buffer_data_address);
-    draw_pixel2buffer(color, x0-r, y0  , buffer_data_address);
-
-    while (x<y) {
-        if (f >= 0) {
-            y--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-
-        x++;
-        ddF_x += 2;
-        f += ddF_x;
-
-        draw_pixel2buffer(color, x0 + x, y0 + y, buffer_data_address);
-        draw_pixel2buffer(color, x0 - x, y0 + y, buffer_data_address);
-        draw_pixel2buffer(color, x0 + x, y0 - y, buffer_data_address);
-        draw_pixel2buffer(color, x0 - x, y0 - y, buffer_data_address);
-        draw_pixel2buffer(color, x0 + y, y0 + x, buffer_data_address);
-        draw_pixel2buffer(color, x0 - y, y0 + x, buffer_data_address);
-        draw_pixel2buffer(color, x0 + y, y0 - x, buffer_data_address);
-        draw_pixel2buffer(color, x0 - y, y0 - x, buffer_data_address);
-    }
-}
-
-// ---------------------------------------------------------------------------
-// This seems to draw filled circle quadrants
-// ---------------------------------------------------------------------------
-static void fill_circle_helper2buffer(uint16_t color,
-                               uint16_t x0, uint16_t y0, uint16_t r,
-                               uint8_t cornername, uint16_t delta, uint16_t buffer_data_address)
-{
-    int16_t f     = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t x     = 0;
-    int16_t y     = r;
-
-    while (x<y) {
-        if (f >= 0) {
-            y--;
-            ddF_y += 2;
-            f     += ddF_y;
-        }
-
-        x++;
-        ddF_x += 2;
-        f     += ddF_x;
-
-        if (cornername & 0x1) {
-            draw_vline2buffer(color, x0+x, y0-y, 2*y+1+delta, buffer_data_address);
-            draw_vline2buffer(color, x0+y, y0-x, 2*x+1+delta, buffer_data_address);
-        }
-        if (cornername & 0x2) {
-            draw_vline2buffer(color, x0-x, y0-y, 2*y+1+delta, buffer_data_address);
-            draw_vline2buffer(color, x0-y, y0-x, 2*x+1+delta, buffer_data_address);
-        }
-    }
-}
-
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
-void fill_circle2buffer(uint16_t color, uint16_t x0, uint16_t y0, uint16_t r, uint16_t buffer_data_address)
-{
-    draw_vline2buffer(color, x0, y0-r, 2*r+1, buffer_data_address);
-    fill_circle_helper2buffer(color, x0, y0, r, 3, 0, buffer_data_address);
-}
-
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
-void draw_rounded_rect2buffer(uint16_t color,
-                       uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t buffer_data_address)
-{
-    draw_hline2buffer(color, x+r  , y    , w-2*r, buffer_data_address); // Top
-    draw_hline2buffer(color, x+r  , y+h-1, w-2*r, buffer_data_address); // Bottom
-    draw_vline2buffer(color, x    , y+r  , h-2*r, buffer_data_address); // Left
-    draw_vline2buffer(color, x+w-1, y+r  , h-2*r, buffer_data_address); // Right
-
-    // draw four corners
-    draw_circle_helper2buffer(color, x+r    , y+r    , r, 1, buffer_data_address);
-    draw_circle_helper2buffer(color, x+w-r-1, y+r    , r, 2, buffer_data_address);
-    draw_circle_helper2buffer(color, x+w-r-1, y+h-r-1, r, 4, buffer_data_address);
-    draw_circle_helper2buffer(color, x+r    , y+h-r-1, r, 8, buffer_data_address);
-}
-
-// ---------------------------------------------------------------------------
-// ---------------------------------------------------------------------------
-void fill_rounded_rect2buffer(uint16_t color,
-                       uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t buffer_data_address)
-{
-    // smarter version
-    fill_rect2buffer(color, x+r, y, w-2*r, h, buffer_data_address);
-
-    // draw four corners
-    fill_circle_helper2buffer(color, x+w-r-1, y+r, r, 1, h-2*r-1, buffer_data_address);
-    fill_circle_helper2buffer(color, x+r    , y+r, r, 2, h-2*r-1, buffer_data_address);
-}
-
-// ---------------------------------------------------------------------------
-// Draw a character at x, y
-// ---------------------------------------------------------------------------
-void draw_char2buffer(char chr, uint16_t x, uint16_t y, uint16_t buffer_data_address)
-{
-    uint8_t i, j;
-
-    if((x >= canvas_w) ||    // Clip right
-       (y >= canvas_h)  ) { // Clip bottom
-        return;
-    }
-
-    for (i=0; i<6; i++ ) {
-        uint8_t line;
-
-        if (i == 5) {
-            line = 0x0;
-        } else {
-            line = pgm_read_byte(font+(chr*5)+i);
-        }
-
-        for ( j = 0; j<8; j++) {
-            if (line & 0x1) {
-                if (textmultiplier == 1) { // default size
-                    draw_pixel2buffer(textcolor, x+i, y+j, buffer_data_address);
-                } else {  // big size
-                    fill_rect2buffer(textcolor, x+(i*textmultiplier), y+(j*textmultiplier), textmultiplier, textmultiplier, buffer_data_address);
-                }
-            } else if (textbgcolor != textcolor) {
-                if (textmultiplier == 1) { // default size
-                    draw_pixel2buffer(textbgcolor, x+i, y+j, buffer_data_address);
-                } else {  // big size
-                    fill_rect2buffer(textbgcolor, x+(i*textmultiplier), y+(j*textmultiplier), textmultiplier, textmultiplier, buffer_data_address);
-                }
-            }
-            line >>= 1;
-        }
-    }
-}
-
-// ---------------------------------------------------------------------------
-// Draw a character at cursor_x, cursor_y, then advance the cursor.
-// ---------------------------------------------------------------------------
-static void draw_char_at_cursor2buffer(char chr, uint16_t buffer_data_address)
-{
-    if (chr == '\n') {
-        cursor_y += textmultiplier*8;
-        cursor_x  = 0;
-    } else if (chr == '\r') {
-        // skip em
-    } else if (chr == '\t') {
-        uint16_t new_x = cursor_x + TABSPACE;
-
-        if (new_x < canvas_w) {
-            cursor_x = new_x;
-        }
-    } else {
-        draw_char2buffer(chr, cursor_x, cursor_y, buffer_data_address);
-        cursor_x += textmultiplier*6;
-
-        if (wrap && (cursor_x > (canvas_w - textmultiplier*6))) {
-            cursor_y += textmultiplier*8;
-            cursor_x = 0;
-        }
-    }
-}
-
-// ---------------------------------------------------------------------------
-// Draw a zero-terminated string at cursor_x, cursor_y, then advance the cursor.
-// ---------------------------------------------------------------------------
-void draw_string2buffer(char * str, uint16_t buffer_data_address)
-{
-    while (*str) {
-        draw_char_at_cursor2buffer(*str++, buffer_data_address);
-    }
-}
+// ---------------------------------------------------------------------------
+// bitmap_graphics_db.c
+//
+// This library was written by tonyvr
+// and upgraded by WojciechGw for double buffering 
+// to simplify bitmap graphics programming
+// of the RP6502 picocomputer designed by Rumbledethumps.
+//
+// This code is an adaptation of the vga_graphics library written by V. Hunter Adams
+// from Cornell University, for his excellent RP2040 microcontroller programming course.
+//
+// https://github.com/vha3/Hunter-Adams-RP2040-Demos/tree/master/VGA_Graphics/VGA_Graphics_Primitives
+//
+// There doesn't seem to be a copyright or a license associated with his code.
+// I don't care what you do with my version either -- have fun!
+// ---------------------------------------------------------------------------
+
+#include <rp6502.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "font5x7.h"
+#include "colors.h"
+#include "bitmap_graphics_db.h"
+#include "xram_io.h"
+
+// Hardware setup
+// defaults
+static uint16_t canvas_struct = 0xFF00;
+static uint16_t canvas_data = 0x0000;  // buffer the canvas shows
+static uint8_t  plane = 0;
+static uint8_t  canvas_mode = 2;
+static uint16_t full_width = 320;      // size set by init_bitmap_graphics,
+static uint16_t full_height = 180;     // canvas_resize stays within it
+
+// Drawing context
+static canvas_t canvas;
+
+// Write-combining cache for sub-byte pixels, direct mapped on the XRAM
+// address. A slot holds the bits drawn into one byte and which ones they
+// are, so the byte is read and written once however many pixels hit it.
+typedef struct {
+    uint16_t addr;
+    uint8_t  mask;      // bits drawn, 0 when the slot is free
+    uint8_t  bits;
+} pixel_cache_entry_t;
+
+static pixel_cache_entry_t pixel_cache[PIXEL_CACHE_SIZE];
+static pixel_cache_stats_t cache_stats;
+
+// Band renderer: between canvas_record_begin and canvas_record_end the
+// primitives below add themselves to a display list instead of drawing.
+// They return false once recording has stopped.
+static bool recording = false;
+static bool record_point(uint16_t color, int16_t x, int16_t y);
+static bool record_span(uint16_t color, int16_t x, int16_t y, int16_t w);
+static bool record_line(uint16_t color, int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+static bool record_triangle(uint16_t color, int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                            int16_t x2, int16_t y2);
+static bool record_glyph(char chr, int16_t x, int16_t y);
+static bool record_blit(uint16_t src, uint16_t offset, uint16_t bytes, uint16_t row_bytes,
+                        int16_t top, int16_t bottom);
+
+// Digits and the minus sign turned from the font's columns into rows of 6
+// pixels (bit 5 is the leftmost one), so numbers draw a row at a time
+#define DIGIT_MINUS 10
+static uint8_t digit_strip[DIGIT_MINUS + 1][8];
+
+// For drawing characters
+// defaults
+static uint16_t cursor_y = 0;
+static uint16_t cursor_x = 0;
+static uint8_t textmultiplier = 1;
+static uint16_t textcolor = 15;
+static uint16_t textbgcolor = 15;
+static bool wrap = true;
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static uint8_t bpp_mode_to_bpp[] = {1, 2, 4, 8, 16};
+static uint8_t bbp_to_bpp_mode(uint8_t bpp)
+{
+    switch(bpp) {
+        case 1:  return 0;
+        case 2:  return 1;
+        case 4:  return 2;
+        case 8:  return 3;
+        case 16: return 4;
+    }
+    return 2; // default
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static void build_digit_strip(void)
+{
+    uint8_t glyph, row, col;
+
+    for (glyph = 0; glyph <= DIGIT_MINUS; glyph++) {
+        const unsigned char *columns = font + ((glyph == DIGIT_MINUS) ? '-' : '0' + glyph) * 5;
+        for (row = 0; row < 8; row++) {
+            uint8_t bits = 0;
+            for (col = 0; col < 5; col++) {
+                if (pgm_read_byte(columns + col) & (1 << row)) {
+                    bits |= 0x20 >> col;
+                }
+            }
+            digit_strip[glyph][row] = bits;
+        }
+    }
+}
+
+void init_bitmap_graphics(uint16_t canvas_struct_address,
+                          uint16_t canvas_data_address,
+                          uint8_t  canvas_plane,
+                          uint8_t  canvas_type,
+                          uint16_t canvas_width,
+                          uint16_t canvas_height,
+                          uint8_t  bits_per_pixel)
+{
+    uint8_t x_offset = 0;
+    uint8_t y_offset = 0;
+
+    // defaults
+    canvas_struct = 0xFF00;
+    canvas_data = 0x0000;
+    plane = 0;
+    canvas_mode = 2;
+    canvas.width = 320;
+    canvas.height = 180;
+    canvas.bpp_mode = 3;
+    canvas.plane_mask = 0xFF;
+    canvas.plane_byte_mask = 0xFF;
+    canvas_flush();
+
+    // valid range check
+    if (canvas_struct_address != 0) {
+        canvas_struct = canvas_struct_address;
+    }
+    if (canvas_data_address != 0) {
+        canvas_data = canvas_data_address;
+    }
+    if (/*canvas_plane >= 0 &&*/ canvas_plane <= 2) {
+        plane = canvas_plane;
+    }
+    if (canvas_type > 0 && canvas_type <= 4) {
+        canvas_mode = canvas_type;
+    }
+    if (canvas_width > 0 && canvas_width <= 640) {
+        canvas.width = canvas_width;
+    }
+    if (canvas_height > 0 && canvas_height <= 480) {
+        canvas.height = canvas_height;
+    }
+    if (bits_per_pixel == 1 ||
+        bits_per_pixel == 2 ||
+        bits_per_pixel == 4 ||
+        bits_per_pixel == 8 ||
+        bits_per_pixel == 16  ) {
+        canvas.bpp_mode = bbp_to_bpp_mode(bits_per_pixel);
+    }
+
+    // additional contraints (due to memory limit of 64K)
+    if (bpp_mode_to_bpp[canvas.bpp_mode] == 16) { // bits color
+        canvas_mode = 2;
+        canvas.width = 240; // max for 16-bit color
+        canvas.height = 124; // max for 16-bit color
+    } else if (bpp_mode_to_bpp[canvas.bpp_mode] == 8) { // bits color
+        canvas_mode = 2;
+        canvas.width = 240; // max for 8-bit color
+        canvas.height = 124; // max for 8-bit color
+    } else if (bpp_mode_to_bpp[canvas.bpp_mode] == 4) { // bits color
+        canvas.width = 320; // max for 4-bit color
+        if (canvas_mode > 2) {
+            canvas_mode = 1;
+            canvas.height = 240; // max for 4-bit color
+        } else if (canvas_mode == 2) {
+            canvas.height = 180; // max for canvas_mode 2
+        }
+    } else if (bpp_mode_to_bpp[canvas.bpp_mode] == 2) { // bits color
+        if (canvas_mode == 4) {
+            canvas.height = 360; // max for canvas_mode 4
+        }
+    }
+
+    // center canvas if necessary
+    if (bpp_mode_to_bpp[canvas.bpp_mode] == 16) {
+        x_offset = 30; // (360 - 240)/4
+        y_offset = 29; // (240 - 124)/4
+    }
+
+    if (canvas_struct_address != canvas_struct) {
+        printf("Asked for canvas_struct_address of 0x%04X, but got 0x%04X\n", canvas_struct_address, canvas_struct);
+    }
+    if (canvas_data_address != canvas_data) {
+        printf("Asked for canvas_data_address of 0x%04X, but got 0x%04X\n", canvas_struct_address, canvas_data);
+    }
+    if (canvas_type != canvas_mode) {
+        printf("Asked for canvas_type of %u, but got %u\n", canvas_type, canvas_mode);
+    }
+    if (canvas_width != canvas.width) {
+        printf("Asked for canvas_width of %u, but got %u\n", canvas_width, canvas.width);
+    }
+    if (canvas_height != canvas.height) {
+        printf("Asked for canvas_height of %u, but got %u\n", canvas_height, canvas.height);
+    }
+    if (bits_per_pixel != bpp_mode_to_bpp[canvas.bpp_mode]) {
+        printf("Asked for bits_per_pixel of %u, but got %u\n", bits_per_pixel, bpp_mode_to_bpp[canvas.bpp_mode]);
+    }
+
+    full_width = canvas.width;
+    full_height = canvas.height;
+    canvas.bpp = bpp_mode_to_bpp[canvas.bpp_mode];
+    canvas.stride = (uint16_t)((uint32_t)canvas.width * canvas.bpp / 8);
+    canvas_target(canvas_data);
+    build_digit_strip();
+
+    //initialize the canvas
+    //xreg_vga_canvas(canvas_mode);
+    xregn(1, 0, 0, 1, canvas_mode);
+
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, x_wrap, false);
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, y_wrap, false);
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, x_pos_px, x_offset);
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, y_pos_px, y_offset);
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, width_px, canvas.width);
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, height_px, canvas.height);
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, xram_data_ptr, canvas_data);
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, xram_palette_ptr, 0xFFFF);
+
+    // initialize the bitmap video modes
+    //xreg_vga_mode(3, canvas.bpp_mode, canvas_struct, plane); // bitmap mode
+    xregn(1, 0, 1, 4, 3, canvas.bpp_mode, canvas_struct, plane);
+
+    printf("canvas_mode: %i, bpp_mode: %i, canvas_struct: %i, plane: %i\n", canvas_mode, canvas.bpp_mode, canvas_struct, plane);
+    printf("canvas_w: %i, canvas_h: %i\n", canvas.width, canvas.height);
+
+    //xreg_vga_mode(0, 1); // console
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+const canvas_t *canvas_context(void)
+{
+    return &canvas;
+}
+
+// ---------------------------------------------------------------------------
+// Rows start stride bytes apart, so the table is built with additions only
+// ---------------------------------------------------------------------------
+void canvas_target(uint16_t buffer_data_address)
+{
+    uint16_t y, addr = buffer_data_address;
+
+    canvas.data = buffer_data_address;
+    for (y = 0; y < canvas.height; y++) {
+        canvas.row[y] = addr;
+        addr += canvas.stride;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Every *2buffer primitive draws through here, a frame normally targets one
+// buffer, so the table is rebuilt about once per frame
+// ---------------------------------------------------------------------------
+static void target(uint16_t buffer_data_address)
+{
+    if (buffer_data_address != canvas.data) {
+        canvas_target(buffer_data_address);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint16_t canvas_buffer(void)
+{
+    return canvas_data;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint16_t canvas_width(void)
+{
+    return canvas.width;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint16_t canvas_height(void)
+{
+    return canvas.height;
+}
+
+// ---------------------------------------------------------------------------
+// The video hardware reads the position with every frame it scans out
+// ---------------------------------------------------------------------------
+void canvas_move(int16_t x, int16_t y)
+{
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, x_pos_px, x);
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, y_pos_px, y);
+}
+
+// ---------------------------------------------------------------------------
+// Rows get shorter, so whatever the buffers hold is laid out for the old
+// size. Width is rounded down to whole bytes.
+// ---------------------------------------------------------------------------
+bool canvas_resize(uint16_t width, uint16_t height)
+{
+    width &= ~(uint16_t)(8 / canvas.bpp - 1);
+    if (width == 0 || height == 0 || width > full_width || height > full_height) {
+        return false;
+    }
+    canvas_flush();
+    canvas.width = width;
+    canvas.height = height;
+    canvas.stride = (uint16_t)((uint32_t)width * canvas.bpp / 8);
+    canvas_target(canvas.data);
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, width_px, width);
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, height_px, height);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Only what depends on the canvas type and size is set up again: the row
+// table and the struct, then the canvas and the bitmap mode in the same
+// order as init_bitmap_graphics
+// ---------------------------------------------------------------------------
+bool canvas_switch(uint8_t canvas_type, uint16_t width, uint16_t height)
+{
+    if (canvas_type == 0 || canvas_type > 4 ||
+        width == 0 || width > 640 || height == 0 || height > 480) {
+        return false;
+    }
+    canvas_flush();
+    canvas_mode = canvas_type;
+    canvas.width = full_width = width;
+    canvas.height = full_height = height;
+    canvas.stride = (uint16_t)((uint32_t)width * canvas.bpp / 8);
+    canvas_target(canvas_data);
+    xregn(1, 0, 0, 1, canvas_mode);
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, width_px, width);
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, height_px, height);
+    xregn(1, 0, 1, 4, 3, canvas.bpp_mode, canvas_struct, plane);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint8_t bits_per_pixel(void)
+{
+    return canvas.bpp;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint16_t random(uint16_t low_limit, uint16_t high_limit)
+{
+    if (low_limit > high_limit) {
+        swap(low_limit, high_limit);
+    }
+
+    return (uint16_t)((rand() % (high_limit-low_limit)) + low_limit);
+}
+
+// ---------------------------------------------------------------------------
+// Set cursor for text to be printed
+// ---------------------------------------------------------------------------
+void set_cursor(uint16_t x, uint16_t y)
+{
+    cursor_x = x;
+    cursor_y = y;
+}
+
+// ---------------------------------------------------------------------------
+// Set multiplier of text to be displayed (1 for 5x7, 2 for 10x14, etc...)
+// ---------------------------------------------------------------------------
+void set_text_multiplier(uint8_t mult)
+{
+    textmultiplier = (mult > 0) ? mult : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Set colors of text to be displayed.
+//     For 'transparent' background, we'll set the bg
+//     to the same as fg instead of using a flag
+// ---------------------------------------------------------------------------
+void set_text_color(uint16_t color)
+{
+    textcolor = textbgcolor = color;
+}
+
+// ---------------------------------------------------------------------------
+// Set colors of text to be displayed
+//      color = color of text
+//      background = color of text background
+// ---------------------------------------------------------------------------
+void set_text_colors(uint16_t color, uint16_t background)
+{
+    textcolor   = color;
+    textbgcolor = background;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void set_text_wrap(bool w)
+{
+    wrap = w;
+}
+
+void switch_buffer(uint16_t buffer_data_address)
+{
+    canvas_flush();
+    canvas_data = buffer_data_address;
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, xram_data_ptr, buffer_data_address);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static uint16_t buffer_bytes(void)
+{
+    return canvas.stride * canvas.height;
+}
+
+// ---------------------------------------------------------------------------
+// Every pixel of a byte set to bits, in the current colour depth
+// ---------------------------------------------------------------------------
+static uint8_t replicate(uint8_t bits)
+{
+    switch (canvas.bpp_mode) {
+        case 2: // 4bpp
+            return (bits & 15) * 0x11;
+        case 1: // 2bpp
+            return (bits & 3) * 0x55;
+        case 0: // 1bpp
+            return (bits & 1) ? 0xFF : 0x00;
+    }
+    return bits;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static pixel_cache_entry_t *cache_slot(uint16_t addr)
+{
+    return &pixel_cache[(uint8_t)(addr ^ (addr >> 6)) & (PIXEL_CACHE_SIZE - 1)];
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static void write_back(const pixel_cache_entry_t *e)
+{
+    RIA.addr1 = e->addr;
+    RIA.step1 = 1;
+    if (e->mask == 0xFF) {
+        RIA.rw1 = e->bits;
+    } else {
+        RIA.addr0 = e->addr;
+        RIA.step0 = 1;
+        RIA.rw1 = (RIA.rw0 & ~e->mask) | e->bits;
+    }
+    cache_stats.written++;
+}
+
+// ---------------------------------------------------------------------------
+// Draw the bits in mask of the byte at addr
+// ---------------------------------------------------------------------------
+static void cache_write(uint16_t addr, uint8_t mask, uint8_t bits)
+{
+    pixel_cache_entry_t *e = cache_slot(addr);
+
+    cache_stats.pixels++;
+    if (e->mask && e->addr == addr) {
+        cache_stats.merged++;
+        e->mask |= mask;
+        e->bits = (e->bits & ~mask) | bits;
+        return;
+    }
+    if (e->mask) {
+        write_back(e);
+    }
+    e->addr = addr;
+    e->mask = mask;
+    e->bits = bits;
+}
+
+// ---------------------------------------------------------------------------
+// A run of whole bytes goes straight to XRAM. Cached pixels inside it were
+// drawn earlier, so the run is applied on top of them too.
+// ---------------------------------------------------------------------------
+static void cache_absorb(uint16_t addr, uint16_t bytes, uint8_t mask, uint8_t bits)
+{
+    pixel_cache_entry_t *e;
+    uint8_t i;
+
+    if (bytes < PIXEL_CACHE_SIZE) {
+        for (; bytes > 0; bytes--, addr++) {
+            e = cache_slot(addr);
+            if (e->mask && e->addr == addr) {
+                e->mask |= mask;
+                e->bits = (e->bits & ~mask) | bits;
+            }
+        }
+    } else {
+        for (i = 0, e = pixel_cache; i < PIXEL_CACHE_SIZE; i++, e++) {
+            if (e->mask && (uint16_t)(e->addr - addr) < bytes) {
+                e->mask |= mask;
+                e->bits = (e->bits & ~mask) | bits;
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Forget the cached pixels of bytes that are about to be overwritten
+// ---------------------------------------------------------------------------
+static void cache_discard(uint16_t addr, uint16_t bytes)
+{
+    pixel_cache_entry_t *e;
+    uint8_t i;
+
+    for (i = 0, e = pixel_cache; i < PIXEL_CACHE_SIZE; i++, e++) {
+        if ((uint16_t)(e->addr - addr) < bytes) {
+            e->mask = 0;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Dirty bytes go out in address order, so neighbours share one run with
+// port 0 reading and port 1 writing behind it
+// ---------------------------------------------------------------------------
+void canvas_flush(void)
+{
+    static uint8_t order[PIXEL_CACHE_SIZE];
+    uint8_t i, j, count = 0;
+
+    for (i = 0; i < PIXEL_CACHE_SIZE; i++) {
+        if (pixel_cache[i].mask) {
+            uint16_t addr = pixel_cache[i].addr;
+            for (j = count++; j > 0 && pixel_cache[order[j - 1]].addr > addr; j--) {
+                order[j] = order[j - 1];
+            }
+            order[j] = i;
+        }
+    }
+
+    RIA.step0 = 1;
+    RIA.step1 = 1;
+    for (i = 0; i < count; i++) {
+        pixel_cache_entry_t *e = &pixel_cache[order[i]];
+        if (i == 0 || e->addr != pixel_cache[order[i - 1]].addr + 1) {
+            RIA.addr0 = e->addr;
+            RIA.addr1 = e->addr;
+        }
+        RIA.rw1 = (RIA.rw0 & ~e->mask) | e->bits;
+        e->mask = 0;
+    }
+    cache_stats.written += count;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+const pixel_cache_stats_t *pixel_cache_stats(void)
+{
+    return &cache_stats;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void set_plane_mask(uint8_t mask)
+{
+    canvas.plane_mask = mask;
+    canvas.plane_byte_mask = replicate(mask);
+}
+
+// ---------------------------------------------------------------------------
+// Clear the planes in mask and keep the others. Each byte is read through
+// port 0 and written back through port 1, so this costs about twice as
+// much per byte as erase_buffer.
+// ---------------------------------------------------------------------------
+void erase_planes2buffer(uint8_t mask, uint16_t buffer_data_address)
+{
+    uint16_t i, num_bytes = buffer_bytes();
+    uint8_t keep = ~replicate(mask);
+
+    canvas_flush();
+    RIA.addr0 = buffer_data_address;
+    RIA.step0 = 1;
+    RIA.addr1 = buffer_data_address;
+    RIA.step1 = 1;
+    for (i = 0; i < (num_bytes & 3); i++) {
+        RIA.rw1 = RIA.rw0 & keep;
+    }
+    for (i = 0; i < (num_bytes/4); i++) {
+        // unrolled for speed
+        RIA.rw1 = RIA.rw0 & keep;
+        RIA.rw1 = RIA.rw0 & keep;
+        RIA.rw1 = RIA.rw0 & keep;
+        RIA.rw1 = RIA.rw0 & keep;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void switch_palette(uint16_t xram_palette_address)
+{
+    canvas_flush();
+    xram0_struct_set(canvas_struct, vga_mode3_config_t, xram_palette_ptr, xram_palette_address);
+}
+
+void erase_buffer(uint16_t buffer_data_address)
+{
+    uint16_t num_bytes = buffer_bytes();
+
+    // cached pixels of this buffer are erased too, without a flush
+    cache_discard(buffer_data_address, num_bytes);
+    xram_fill(buffer_data_address, 0, num_bytes);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void copy_buffer(uint16_t src_data_address, uint16_t buffer_data_address)
+{
+    canvas_flush();
+    xram_copy(buffer_data_address, src_data_address, buffer_bytes());
+}
+
+// ---------------------------------------------------------------------------
+// One copy per row, from the image row to the row table entry
+// ---------------------------------------------------------------------------
+void blit2buffer(uint16_t xram_image_address, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                 uint16_t buffer_data_address)
+{
+    uint16_t row_bytes, bytes, offset;
+
+    target(buffer_data_address);
+    canvas_flush();
+    row_bytes = (uint16_t)((uint32_t)w * canvas.bpp / 8);
+    offset = (uint16_t)((uint32_t)x * canvas.bpp / 8);
+    if (offset >= canvas.stride) { // Clip
+        return;
+    }
+    bytes = row_bytes;
+    if (bytes > canvas.stride - offset) {
+        bytes = canvas.stride - offset;
+    }
+    if (recording && h > 0 && y < canvas.height &&
+        record_blit(xram_image_address, offset, bytes, row_bytes, y,
+                    (y + h > canvas.height) ? canvas.height - 1 : y + h - 1)) {
+        return;
+    }
+
+    for (; h > 0 && y < canvas.height; h--, y++) {
+        xram_copy(canvas.row[y] + offset, xram_image_address, bytes);
+        xram_image_address += row_bytes;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// A byte with every pixel set to color the way plot() sets one, so whole
+// bytes and single pixels of a shape agree: at 1bpp any colour but 0 is set
+// ---------------------------------------------------------------------------
+static uint8_t pixel_fill(uint16_t color)
+{
+    if (canvas.bpp == 1) {
+        return color ? 0xFF : 0x00;
+    }
+    if (canvas.bpp_mode == 1 && color > 0 && (color % 4) == 0) { // 2bpp
+        color = 1; // avoid 'accidental' black
+    }
+    return replicate(color);
+}
+
+// ---------------------------------------------------------------------------
+// Set one pixel of the target buffer
+// ---------------------------------------------------------------------------
+static void plot(uint16_t color, uint16_t x, uint16_t y)
+{
+    uint16_t addr;
+    uint8_t shift, mask;
+
+    if (x >= canvas.width || y >= canvas.height) { // Clip
+        return;
+    }
+    if (recording && record_point(color, x, y)) {
+        return;
+    }
+
+    if (canvas.bpp_mode == 4) { // 16bpp
+        RIA.addr1 = canvas.row[y] + (x << 1);
+        RIA.step1 = 1;
+        RIA.rw1 = color;
+        RIA.rw1 = color >> 8;
+        return;
+    } else if (canvas.bpp_mode == 3) { // 8bpp
+        RIA.addr1 = canvas.row[y] + x;
+        RIA.step1 = 1;
+        RIA.rw1 = color;
+        return;
+    } else if (canvas.bpp_mode == 2) { // 4bpp
+        shift = 4 * (1 - (x & 1));
+        addr = canvas.row[y] + (x >> 1);
+        mask = (canvas.plane_mask & 15) << shift;
+    } else if (canvas.bpp_mode == 1) { // 2bpp
+        shift = 2 * (3 - (x & 3));
+        addr = canvas.row[y] + (x >> 2);
+        if (color > 0 && (color % 4) == 0) {
+            color = 1; // avoid 'accidental' black
+        }
+        mask = (canvas.plane_mask & 3) << shift;
+    } else { // 1bpp
+        shift = 1 * (7 - (x & 7));
+        addr = canvas.row[y] + (x >> 3);
+        color = (color != 0) ? 0xFF : 0;
+        mask = 1 << shift;
+    }
+    cache_write(addr, mask, (color << shift) & mask);
+}
+
+void draw_pixel2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t buffer_data_address)
+{
+    target(buffer_data_address);
+    plot(color, x, y);
+}
+
+static void hline(uint16_t color, uint16_t x, uint16_t y, uint16_t w);
+static void vline(uint16_t color, uint16_t x, uint16_t y, uint16_t h);
+
+// ---------------------------------------------------------------------------
+// Line stepper of both the direct and the banded lines, so banding changes
+// how a line is drawn but not its pixels. A line is walked along its major
+// axis (x, or y when steep) as runs, one per minor step. Pixel by pixel,
+// Bresenham's loop with err starting at dx / 2 plots, takes dy from err and
+// steps the minor axis when err goes below zero; a run is the pixels
+// between two such steps. From any err in [0, dx) the first run is
+// err / dy + 1 long, and every run after it starts with err in
+// [dx - dy, dx), so it is q or q + 1 pixels, q = dx / dy, and q + 1
+// exactly when err >= q * dy. Only that choice is made per run.
+// ---------------------------------------------------------------------------
+typedef struct {
+    int16_t major, minor;   // first pixel of the run
+    int16_t length;         // pixels in the run
+    int16_t left;           // pixels from the run on to the end of the line
+    int16_t dx, dy;         // major and minor extent, dx >= dy
+    int16_t q, q_step, r;   // dx / dy, q * dy and dx - q * dy
+    int16_t err;            // err at the start of the next run
+    int8_t  major_step, minor_step;
+    bool    steep;
+} line_steps_t;
+
+static void line_first_run(line_steps_t *l, int16_t err)
+{
+    if (l->dy == 0) {
+        l->length = l->left;
+        return;
+    }
+    l->length = err / l->dy + 1;
+    l->err = err % l->dy + l->dx - l->dy;
+    if (l->length > l->left) {
+        l->length = l->left;
+    }
+}
+
+static void line_start(line_steps_t *l, int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    l->steep = abs(y1 - y0) > abs(x1 - x0);
+    if (l->steep) {
+        swap(x0, y0);
+        swap(x1, y1);
+    }
+    if (x0 > x1) {
+        swap(x0, x1);
+        swap(y0, y1);
+    }
+    l->major = x0;
+    l->minor = y0;
+    l->dx = x1 - x0;
+    l->dy = abs(y1 - y0);
+    l->left = l->dx + 1;
+    l->major_step = 1;
+    l->minor_step = (y0 < y1) ? 1 : -1;
+    if (l->dy > 0) {
+        l->q = l->dx / l->dy;
+        l->q_step = l->q * l->dy;
+        l->r = l->dx - l->q_step;
+    }
+    line_first_run(l, l->dx / 2);
+}
+
+// ---------------------------------------------------------------------------
+// Walk a line that was just started from its far end, with the same pixels.
+// Going back, err grows by dy and wraps by dx, which is the forward walk of
+// dx - 1 - err. The err and minor of the last pixel come from the number
+// of minor steps w: err = dx / 2 - dx * dy + w * dx lies in [0, dx).
+// ---------------------------------------------------------------------------
+static void line_reverse(line_steps_t *l)
+{
+    int32_t t;
+    int16_t w;
+
+    if (l->dy == 0) {
+        return;
+    }
+    t = (int32_t)l->dx * l->dy - l->dx / 2;
+    w = (int16_t)((t + l->dx - 1) / l->dx);
+    l->major += l->dx;
+    l->minor += l->minor_step * w;
+    l->major_step = -l->major_step;
+    l->minor_step = -l->minor_step;
+    line_first_run(l, l->dx - 1 - (int16_t)((int32_t)w * l->dx - t));
+}
+
+// ---------------------------------------------------------------------------
+// Step to the next run, false past the end of the line
+// ---------------------------------------------------------------------------
+static bool line_next(line_steps_t *l)
+{
+    l->left -= l->length;
+    if (l->left <= 0) {
+        return false;
+    }
+    l->major += (l->major_step > 0) ? l->length : -l->length;
+    l->minor += l->minor_step;
+    if (l->err >= l->q_step) {
+        l->length = l->q + 1;
+        l->err += l->r - l->dy;
+    } else {
+        l->length = l->q;
+        l->err += l->r;
+    }
+    if (l->length > l->left) {
+        l->length = l->left;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// A run as a span, clipped where the unsigned span writers cannot
+// ---------------------------------------------------------------------------
+static void line_run(uint16_t color, int16_t major, int16_t minor, int16_t length, bool steep)
+{
+    if (major < 0) {
+        length += major;
+        major = 0;
+    }
+    if (length <= 0 || minor < 0) {
+        return;
+    }
+    if (steep) {
+        vline(color, minor, major, length);
+    } else {
+        hline(color, major, minor, length);
+    }
+}
+
+void draw_line2buffer(uint16_t color, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t buffer_data_address)
+{
+    line_steps_t line;
+    int16_t i;
+
+    target(buffer_data_address);
+    if (recording && record_line(color, x0, y0, x1, y1)) {
+        return;
+    }
+    line_start(&line, x0, y0, x1, y1);
+
+    // runs of two pixels or more on average are cheaper as spans
+    if (line.dx >= LINE_RUN_SLOPE * line.dy) {
+        if (canvas.bpp == 1 && color != 0) {
+            color = 1; // plot() sets the pixel for any colour but 0
+        }
+        do {
+            line_run(color, line.major, line.minor, line.length, line.steep);
+        } while (line_next(&line));
+        return;
+    }
+
+    do {
+        for (i = 0; i < line.length; i++) {
+            if (line.steep) {
+                plot(color, line.minor, line.major + i);
+            } else {
+                plot(color, line.major + i, line.minor);
+            }
+        }
+    } while (line_next(&line));
+}
+
+static void vline(uint16_t color, uint16_t x, uint16_t y, uint16_t h)
+{
+    uint16_t i;
+    if (recording && h > 0 && record_line(color, x, y, x, y + h - 1)) {
+        return;
+    }
+    for (i=y; i<(y+h); i++) {
+        plot(color, x, i);
+    }
+}
+
+void draw_vline2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t h, uint16_t buffer_data_address)
+{
+    target(buffer_data_address);
+    vline(color, x, y, h);
+}
+
+// ---------------------------------------------------------------------------
+// Spans write whole bytes where they can: every pixel of such a byte is
+// overwritten, so it is stored without reading it back first
+// ---------------------------------------------------------------------------
+static void hline(uint16_t color, uint16_t x, uint16_t y, uint16_t w)
+{
+    uint8_t bpp = canvas.bpp;
+    uint8_t pixels_per_byte, fill;
+    uint16_t bytes;
+
+    if (x >= canvas.width || y >= canvas.height) { // Clip
+        return;
+    }
+    if (w > canvas.width - x) {
+        w = canvas.width - x;
+    }
+    if (recording && record_span(color, x, y, w)) {
+        return;
+    }
+
+    if (bpp >= 8) {
+        RIA.addr1 = canvas.row[y] + x * (bpp / 8);
+        RIA.step1 = 1;
+        if (bpp == 8) {
+            while (w--) {
+                RIA.rw1 = color;
+            }
+        } else {
+            while (w--) {
+                RIA.rw1 = color;
+                RIA.rw1 = color >> 8;
+            }
+        }
+        return;
+    }
+
+    // leading pixels that share a byte with pixels outside the span
+    pixels_per_byte = 8 / bpp;
+    while (w > 0 && (x & (pixels_per_byte - 1))) {
+        plot(color, x++, y);
+        w--;
+    }
+
+    bytes = w / pixels_per_byte;
+    if (bytes > 0) {
+        uint16_t addr = canvas.row[y] + x / pixels_per_byte;
+        fill = pixel_fill(color);
+        cache_absorb(addr, bytes, canvas.plane_byte_mask, fill & canvas.plane_byte_mask);
+        RIA.addr1 = addr;
+        RIA.step1 = 1;
+        x += bytes * pixels_per_byte;
+        w -= bytes * pixels_per_byte;
+        if (canvas.plane_byte_mask == 0xFF) {
+            while (bytes--) {
+                RIA.rw1 = fill;
+            }
+        } else {
+            // other planes must be kept, read them through port 0
+            uint8_t keep = ~canvas.plane_byte_mask;
+            fill &= canvas.plane_byte_mask;
+            RIA.addr0 = addr;
+            RIA.step0 = 1;
+            while (bytes--) {
+                RIA.rw1 = (RIA.rw0 & keep) | fill;
+            }
+        }
+    }
+
+    // trailing pixels
+    while (w > 0) {
+        plot(color, x++, y);
+        w--;
+    }
+}
+
+void draw_hline2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t buffer_data_address)
+{
+    target(buffer_data_address);
+    hline(color, x, y, w);
+}
+
+void draw_rect2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t buffer_data_address)
+{
+    target(buffer_data_address);
+    hline(color, x, y, w);
+    hline(color, x, y+h-1, w);
+    vline(color, x, y, h);
+    vline(color, x+w-1, y, h);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static void fill_rect(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    uint16_t j;
+    for(j=y; j<(y+h); j++) {
+        hline(color, x, j, w);
+    }
+}
+
+void fill_rect2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t buffer_data_address)
+{
+    target(buffer_data_address);
+    fill_rect(color, x, y, w, h);
+}
+
+// ---------------------------------------------------------------------------
+// This seems to draw circle quadrants
+// ---------------------------------------------------------------------------
+static void draw_circle_helper(uint16_t color,
+                               uint16_t x0, uint16_t y0, uint16_t r,
+                               uint8_t cornername)
+{
+    int16_t f     = 1 - r;
+    int16_t ddF_x = 1;
+    int16_t ddF_y = -2 * r;
+    int16_t x     = 0;
+    int16_t y     = r;
+
+    while (x<y) {
+        if (f >= 0) {
+            y--;
+            ddF_y += 2;
+            f     += ddF_y;
+        }
+
+        x++;
+        ddF_x += 2;
+        f     += ddF_x;
+
+        if (cornername & 0x4) {
+            plot(color, x0 + x, y0 + y);
+            plot(color, x0 + y, y0 + x);
+        }
+        if (cornername & 0x2) {
+            plot(color, x0 + x, y0 - y);
+            plot(color, x0 + y, y0 - x);
+        }
+        if (cornername & 0x8) {
+            plot(color, x0 - y, y0 + x);
+            plot(color, x0 - x, y0 + y);
+        }
+        if (cornername & 0x1) {
+            plot(color, x0 - y, y0 - x);
+            plot(color, x0 - x, y0 - y);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void draw_circle2buffer(uint16_t color, uint16_t x0, uint16_t y0, uint16_t r, uint16_t buffer_data_address)
+{
+    int16_t f = 1 - r;
+    int16_t ddF_x = 1;
+    int16_t ddF_y = -2 * r;
+    int16_t x = 0;
+    int16_t y = r;
+
+    target(buffer_data_address);
+    plot(color, x0  , y0+r);
+    plot(color, x0  , y0-r);
+    plot(color, x0+r, y0  );
+    plot(color, x0-r, y0  );
+
+    while (x<y) {
+        if (f >= 0) {
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+
+        plot(color, x0 + x, y0 + y);
+        plot(color, x0 - x, y0 + y);
+        plot(color, x0 + x, y0 - y);
+        plot(color, x0 - x, y0 - y);
+        plot(color, x0 + y, y0 + x);
+        plot(color, x0 - y, y0 + x);
+        plot(color, x0 + y, y0 - x);
+        plot(color, x0 - y, y0 - x);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// This seems to draw filled circle quadrants
+// ---------------------------------------------------------------------------
+static void fill_circle_helper(uint16_t color,
+                               uint16_t x0, uint16_t y0, uint16_t r,
+                               uint8_t cornername, uint16_t delta)
+{
+    int16_t f     = 1 - r;
+    int16_t ddF_x = 1;
+    int16_t ddF_y = -2 * r;
+    int16_t x     = 0;
+    int16_t y     = r;
+
+    while (x<y) {
+        if (f >= 0) {
+            y--;
+            ddF_y += 2;
+            f     += ddF_y;
+        }
+
+        x++;
+        ddF_x += 2;
+        f     += ddF_x;
+
+        if (cornername & 0x1) {
+            vline(color, x0+x, y0-y, 2*y+1+delta);
+            vline(color, x0+y, y0-x, 2*x+1+delta);
+        }
+        if (cornername & 0x2) {
+            vline(color, x0-x, y0-y, 2*y+1+delta);
+            vline(color, x0-y, y0-x, 2*x+1+delta);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void fill_circle2buffer(uint16_t color, uint16_t x0, uint16_t y0, uint16_t r, uint16_t buffer_data_address)
+{
+    target(buffer_data_address);
+    vline(color, x0, y0-r, 2*r+1);
+    fill_circle_helper(color, x0, y0, r, 3, 0);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void draw_rounded_rect2buffer(uint16_t color,
+                       uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t buffer_data_address)
+{
+    target(buffer_data_address);
+    hline(color, x+r  , y    , w-2*r); // Top
+    hline(color, x+r  , y+h-1, w-2*r); // Bottom
+    vline(color, x    , y+r  , h-2*r); // Left
+    vline(color, x+w-1, y+r  , h-2*r); // Right
+
+    // draw four corners
+    draw_circle_helper(color, x+r    , y+r    , r, 1);
+    draw_circle_helper(color, x+w-r-1, y+r    , r, 2);
+    draw_circle_helper(color, x+w-r-1, y+h-r-1, r, 4);
+    draw_circle_helper(color, x+r    , y+h-r-1, r, 8);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void fill_rounded_rect2buffer(uint16_t color,
+                       uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t buffer_data_address)
+{
+    // smarter version
+    target(buffer_data_address);
+    fill_rect(color, x+r, y, w-2*r, h);
+
+    // draw four corners
+    fill_circle_helper(color, x+w-r-1, y+r, r, 1, h-2*r-1);
+    fill_circle_helper(color, x+r    , y+r, r, 2, h-2*r-1);
+}
+
+// ---------------------------------------------------------------------------
+// Walks the x coordinate of a triangle edge one row at a time
+// ---------------------------------------------------------------------------
+typedef struct {
+    int16_t x;
+    int16_t step;
+    int16_t rem;
+    int16_t err;
+    int16_t dy;
+    int8_t  sign;
+} tri_edge_t;
+
+static void tri_edge_start(tri_edge_t *e, int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    int16_t dx = x1 - x0;
+
+    e->x    = x0;
+    e->dy   = y1 - y0;
+    e->err  = 0;
+    e->sign = (dx < 0) ? -1 : 1;
+    if (e->dy > 0) {
+        e->step = dx / e->dy;
+        e->rem  = abs(dx % e->dy);
+    } else {
+        e->step = 0;
+        e->rem  = 0;
+    }
+}
+
+static void tri_edge_advance(tri_edge_t *e)
+{
+    e->x   += e->step;
+    e->err += e->rem;
+    if (e->err >= e->dy) {
+        e->err -= e->dy;
+        e->x   += e->sign;
+    }
+}
+
+static void tri_span(uint16_t color, int16_t a, int16_t b, int16_t y)
+{
+    if (a > b) {
+        swap(a, b);
+    }
+    if (y < 0 || y >= (int16_t)canvas.height || b < 0 || a >= (int16_t)canvas.width) { // Clip
+        return;
+    }
+    if (a < 0) {
+        a = 0;
+    }
+    if (b >= (int16_t)canvas.width) {
+        b = canvas.width - 1;
+    }
+    hline(color, a, y, b - a + 1);
+}
+
+// ---------------------------------------------------------------------------
+// Draw a filled triangle, one horizontal span per row
+// ---------------------------------------------------------------------------
+void fill_triangle2buffer(uint16_t color, int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                   int16_t x2, int16_t y2, uint16_t buffer_data_address)
+{
+    tri_edge_t long_edge, short_edge;
+    int16_t y;
+
+    // Sort coordinates by Y order (y2 >= y1 >= y0)
+    if (y0 > y1) {
+        swap(y0, y1); swap(x0, x1);
+    }
+    if (y1 > y2) {
+        swap(y2, y1); swap(x2, x1);
+    }
+    if (y0 > y1) {
+        swap(y0, y1); swap(x0, x1);
+    }
+
+    target(buffer_data_address);
+    if (recording && record_triangle(color, x0, y0, x1, y1, x2, y2)) {
+        return;
+    }
+    tri_edge_start(&long_edge, x0, y0, x2, y2);
+    tri_edge_start(&short_edge, x0, y0, x1, y1);
+    for (y = y0; y < y1; y++) {
+        tri_span(color, long_edge.x, short_edge.x, y);
+        tri_edge_advance(&long_edge);
+        tri_edge_advance(&short_edge);
+    }
+    tri_edge_start(&short_edge, x1, y1, x2, y2);
+    for (; y <= y2; y++) {
+        tri_span(color, long_edge.x, short_edge.x, y);
+        tri_edge_advance(&long_edge);
+        tri_edge_advance(&short_edge);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Draw a character at x, y
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// Draw a glyph of the digit strip at 1, 2 or 4bpp. The pixels of a row that
+// share a byte go to the pixel cache as one write.
+// ---------------------------------------------------------------------------
+static void draw_strip_glyph(uint8_t glyph, uint16_t x, uint16_t y)
+{
+    uint8_t bpp = canvas.bpp;
+    uint8_t pixel_mask = (1 << bpp) - 1;
+    uint8_t last = 8 / bpp - 1;     // pixels per byte - 1
+    uint8_t fg = pixel_fill(textcolor);
+    uint8_t bg = pixel_fill(textbgcolor);
+    bool opaque = textbgcolor != textcolor;
+    uint8_t width = 6, row, i;
+
+    if (canvas.width - x < width) {
+        width = canvas.width - x;
+    }
+    for (row = 0; row < 8 && y + row < canvas.height; row++) {
+        uint8_t bits = digit_strip[glyph][row];
+        uint16_t addr = canvas.row[y + row] + x / (last + 1);
+        uint8_t shift = (last - (x & last)) * bpp;
+        uint8_t mask = 0, byte = 0;
+
+        if (bits == 0 && !opaque) {
+            continue;
+        }
+        for (i = 0; i < width; i++) {
+            if (bits & (0x20 >> i)) {
+                mask |= pixel_mask << shift;
+                byte |= fg & (pixel_mask << shift);
+            } else if (opaque) {
+                mask |= pixel_mask << shift;
+                byte |= bg & (pixel_mask << shift);
+            }
+            if (shift == 0 || i == width - 1) {
+                mask &= canvas.plane_byte_mask;
+                if (mask) {
+                    cache_write(addr, mask, byte & mask);
+                }
+                addr++;
+                shift = 8;
+                mask = byte = 0;
+            }
+            shift -= bpp;
+        }
+    }
+}
+
+void draw_char2buffer(char chr, uint16_t x, uint16_t y, uint16_t buffer_data_address)
+{
+    uint8_t i, j;
+
+    if((x >= canvas.width) ||    // Clip right
+       (y >= canvas.height)  ) { // Clip bottom
+        return;
+    }
+
+    target(buffer_data_address);
+    if (recording && record_glyph(chr, x, y)) {
+        return;
+    }
+    if (textmultiplier == 1 && canvas.bpp < 8) {
+        if (chr >= '0' && chr <= '9') {
+            draw_strip_glyph(chr - '0', x, y);
+            return;
+        }
+        if (chr == '-') {
+            draw_strip_glyph(DIGIT_MINUS, x, y);
+            return;
+        }
+    }
+    for (i=0; i<6; i++ ) {
+        uint8_t line;
+
+        if (i == 5) {
+            line = 0x0;
+        } else {
+            line = pgm_read_byte(font+(chr*5)+i);
+        }
+
+        for ( j = 0; j<8; j++) {
+            if (line & 0x1) {
+                if (textmultiplier == 1) { // default size
+                    plot(textcolor, x+i, y+j);
+                } else {  // big size
+                    fill_rect(textcolor, x+(i*textmultiplier), y+(j*textmultiplier), textmultiplier, textmultiplier);
+                }
+            } else if (textbgcolor != textcolor) {
+                if (textmultiplier == 1) { // default size
+                    plot(textbgcolor, x+i, y+j);
+                } else {  // big size
+                    fill_rect(textbgcolor, x+(i*textmultiplier), y+(j*textmultiplier), textmultiplier, textmultiplier);
+                }
+            }
+            line >>= 1;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Draw a character at cursor_x, cursor_y, then advance the cursor.
+// ---------------------------------------------------------------------------
+static void draw_char_at_cursor2buffer(char chr, uint16_t buffer_data_address)
+{
+    if (chr == '\n') {
+        cursor_y += textmultiplier*8;
+        cursor_x  = 0;
+    } else if (chr == '\r') {
+        // skip em
+    } else if (chr == '\t') {
+        uint16_t new_x = cursor_x + TABSPACE;
+
+        if (new_x < canvas.width) {
+            cursor_x = new_x;
+        }
+    } else {
+        draw_char2buffer(chr, cursor_x, cursor_y, buffer_data_address);
+        cursor_x += textmultiplier*6;
+
+        if (wrap && (cursor_x > (canvas.width - textmultiplier*6))) {
+            cursor_y += textmultiplier*8;
+            cursor_x = 0;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Draw a zero-terminated string at cursor_x, cursor_y, then advance the cursor.
+// ---------------------------------------------------------------------------
+void draw_string2buffer(char * str, uint16_t buffer_data_address)
+{
+    while (*str) {
+        draw_char_at_cursor2buffer(*str++, buffer_data_address);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Digits are counted out by subtracting powers of ten, the 6502 has no
+// divide instruction
+// ---------------------------------------------------------------------------
+uint8_t format_int(char *str, int16_t value)
+{
+    static const uint16_t powers[] = {10000, 1000, 100, 10};
+    uint16_t n = (uint16_t)value;
+    char *p = str;
+    bool leading = true;
+    uint8_t i;
+
+    if (value < 0) {
+        *p++ = '-';
+        n = -n;
+    }
+    for (i = 0; i < sizeof(powers) / sizeof(powers[0]); i++) {
+        char digit = '0';
+        while (n >= powers[i]) {
+            n -= powers[i];
+            digit++;
+        }
+        if (digit != '0' || !leading) {
+            *p++ = digit;
+            leading = false;
+        }
+    }
+    *p++ = '0' + n;
+    *p = '\0';
+    return p - str;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint8_t format_ulong(char *str, uint32_t value)
+{
+    static const uint32_t powers[] = {
+        1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10
+    };
+    char *p = str;
+    bool leading = true;
+    uint8_t i;
+
+    for (i = 0; i < sizeof(powers) / sizeof(powers[0]); i++) {
+        char digit = '0';
+        while (value >= powers[i]) {
+            value -= powers[i];
+            digit++;
+        }
+        if (digit != '0' || !leading) {
+            *p++ = digit;
+            leading = false;
+        }
+    }
+    *p++ = '0' + (uint8_t)value;
+    *p = '\0';
+    return p - str;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void draw_int2buffer(int16_t value, uint16_t buffer_data_address)
+{
+    char str[FORMAT_INT_BYTES];
+
+    format_int(str, value);
+    draw_string2buffer(str, buffer_data_address);
+}
+
+// ---------------------------------------------------------------------------
+// Band renderer
+//
+// The frame is rasterized one band of rows at a time into band_scratch in
+// RAM, over the whole display list, and each band is streamed to XRAM
+// through port 1. Every byte of the buffer is written once and never
+// read, which also clears it. Lines and triangles keep their stepping
+// state in the list, so each one is walked once over all bands.
+// ---------------------------------------------------------------------------
+enum {
+    ITEM_POINTS,    // single pixels close together, in one colour
+    ITEM_SPAN,
+    ITEM_LINE,
+    ITEM_TRIANGLE,
+    ITEM_GLYPH,
+    ITEM_BLIT
+};
+
+// Pixels of a point list, as offsets from its first one (no larger than
+// the triangle entry of the union)
+#define ITEM_POINTS_MAX 11
+
+typedef struct {
+    uint8_t kind;
+    uint8_t fill;       // colour over a whole byte
+    int16_t top;        // first row still to draw
+    int16_t bottom;     // last row
+    union {
+        struct { int16_t x, w; } span;
+        line_steps_t line;
+        struct { tri_edge_t long_edge, short_edge; int16_t x1, y1, x2; } tri;
+        struct { int16_t x; char chr; uint8_t mult; uint8_t bg_fill; bool bg; } glyph;
+        struct { int16_t x, y; uint8_t count; int8_t dx[ITEM_POINTS_MAX], dy[ITEM_POINTS_MAX]; } points;
+        struct { uint16_t src, offset, bytes, row_bytes; } blit;
+    } u;
+} band_item_t;
+
+static band_item_t band_items[BAND_MAX_ITEMS];
+static uint8_t band_count;
+static uint8_t band_scratch[BAND_BYTES];
+static uint8_t *band_row[BAND_MAX_ROWS];
+static uint8_t band_rows;
+static int16_t band_top, band_bottom;   // rows of the band being drawn
+static uint8_t band_ppb_mask;           // pixels per byte - 1
+static uint8_t band_x_shift;            // x to byte
+static uint8_t band_bpp_shift;          // log2 of bits per pixel
+static uint8_t band_lead_mask;          // the leftmost pixel of a byte
+static band_stats_t band_stats;
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool canvas_record_begin(uint16_t buffer_data_address)
+{
+    uint8_t i;
+
+    if (canvas.bpp > 4 || canvas.plane_byte_mask != 0xFF) {
+        return false;
+    }
+    target(buffer_data_address);
+    band_rows = BAND_BYTES / canvas.stride;
+    if (band_rows > BAND_MAX_ROWS) {
+        band_rows = BAND_MAX_ROWS;
+    }
+    if (band_rows == 0) {
+        return false;
+    }
+    for (i = 0; i < band_rows; i++) {
+        band_row[i] = band_scratch + i * canvas.stride;
+    }
+    band_bpp_shift = canvas.bpp_mode;       // 1, 2, 4bpp: 0, 1, 2
+    band_x_shift = 3 - band_bpp_shift;
+    band_ppb_mask = (1 << band_x_shift) - 1;
+    band_lead_mask = (uint8_t)(0xFF00 >> canvas.bpp);
+    band_count = 0;
+    // the whole buffer is about to be overwritten
+    cache_discard(buffer_data_address, buffer_bytes());
+    recording = true;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static void band_pixel(uint8_t *row, int16_t x, uint8_t fill)
+{
+    uint8_t mask = band_lead_mask >> ((x & band_ppb_mask) << band_bpp_shift);
+    uint8_t *p = row + (x >> band_x_shift);
+    *p = (*p & ~mask) | (fill & mask);
+}
+
+// ---------------------------------------------------------------------------
+// Pixels a..b of row y, clipped to the canvas and the band
+// ---------------------------------------------------------------------------
+static void band_span(uint8_t fill, int16_t a, int16_t b, int16_t y)
+{
+    uint8_t *row;
+
+    if (y < band_top || y >= band_bottom) {
+        return;
+    }
+    if (a < 0) {
+        a = 0;
+    }
+    if (b >= (int16_t)canvas.width) {
+        b = canvas.width - 1;
+    }
+    row = band_row[y - band_top];
+    while (a <= b && (a & band_ppb_mask)) {
+        band_pixel(row, a++, fill);
+    }
+    while (b - a >= band_ppb_mask) {
+        row[a >> band_x_shift] = fill;
+        a += band_ppb_mask + 1;
+    }
+    while (a <= b) {
+        band_pixel(row, a++, fill);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Draw the part of item inside the current band
+// ---------------------------------------------------------------------------
+static void band_draw(band_item_t *item)
+{
+    switch (item->kind) {
+    case ITEM_POINTS: {
+        uint8_t i;
+        for (i = 0; i < item->u.points.count; i++) {
+            int16_t y = item->u.points.y + item->u.points.dy[i];
+            if (y >= band_top && y < band_bottom) {
+                band_pixel(band_row[y - band_top], item->u.points.x + item->u.points.dx[i], item->fill);
+            }
+        }
+        item->top = band_bottom;
+        break;
+    }
+    case ITEM_SPAN:
+        band_span(item->fill, item->u.span.x, item->u.span.x + item->u.span.w - 1, item->top);
+        item->top++;
+        break;
+    case ITEM_LINE: {
+        // runs come in row order (see record_line); a steep run down a
+        // column is cut at the bottom of the band and resumed in the next
+        line_steps_t *l = &item->u.line;
+        do {
+            if (l->steep) {
+                bool inside = l->minor >= 0 && l->minor < (int16_t)canvas.width;
+                while (l->length > 0) {
+                    if (l->major >= band_bottom) {
+                        item->top = l->major;
+                        return;
+                    }
+                    if (inside && l->major >= band_top) {
+                        band_pixel(band_row[l->major - band_top], l->minor, item->fill);
+                    }
+                    l->major++;
+                    l->left--;
+                    l->length--;
+                }
+            } else {
+                int16_t a = l->major;
+                int16_t b = a + ((l->major_step > 0) ? l->length - 1 : 1 - l->length);
+                if (l->minor >= band_bottom) {
+                    item->top = l->minor;
+                    return;
+                }
+                if (a > b) {
+                    swap(a, b);
+                }
+                band_span(item->fill, a, b, l->minor);
+            }
+        } while (line_next(l));
+        item->top = item->bottom + 1;
+        break;
+    }
+    case ITEM_TRIANGLE:
+        while (item->top <= item->bottom && item->top < band_bottom) {
+            if (item->top == item->u.tri.y1) {
+                tri_edge_start(&item->u.tri.short_edge, item->u.tri.x1, item->u.tri.y1,
+                               item->u.tri.x2, item->bottom);
+            }
+            if (item->top >= band_top) {
+                int16_t a = item->u.tri.long_edge.x;
+                int16_t b = item->u.tri.short_edge.x;
+                if (a > b) {
+                    swap(a, b);
+                }
+                band_span(item->fill, a, b, item->top);
+            }
+            tri_edge_advance(&item->u.tri.long_edge);
+            tri_edge_advance(&item->u.tri.short_edge);
+            item->top++;
+        }
+        break;
+    case ITEM_GLYPH: {
+        uint8_t mult = item->u.glyph.mult;
+        int16_t y0 = item->bottom + 1 - 8 * mult;   // top row of the glyph
+        uint8_t i, j;
+        for (j = 0; j < 8; j++) {
+            int16_t y = y0 + j * mult;
+            int16_t r;
+            if (y >= band_bottom) {
+                break;
+            }
+            if (y + mult <= band_top) {
+                continue;
+            }
+            for (i = 0; i < 6; i++) {
+                uint8_t line = (i == 5) ? 0 : pgm_read_byte(font + (item->u.glyph.chr * 5) + i);
+                int16_t x = item->u.glyph.x + i * mult;
+                if (line & (1 << j)) {
+                    for (r = 0; r < mult; r++) {
+                        band_span(item->fill, x, x + mult - 1, y + r);
+                    }
+                } else if (item->u.glyph.bg) {
+                    for (r = 0; r < mult; r++) {
+                        band_span(item->u.glyph.bg_fill, x, x + mult - 1, y + r);
+                    }
+                }
+            }
+        }
+        item->top = band_bottom;
+        break;
+    }
+    case ITEM_BLIT:
+        // the image rows come from XRAM through port 0
+        while (item->top <= item->bottom && item->top < band_bottom) {
+            xram_read(band_row[item->top - band_top] + item->u.blit.offset,
+                      item->u.blit.src, item->u.blit.bytes);
+            item->u.blit.src += item->u.blit.row_bytes;
+            item->top++;
+        }
+        break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Rasterize the display list band by band and stream the bands to XRAM
+// ---------------------------------------------------------------------------
+static void band_render(void)
+{
+    uint8_t i;
+
+    recording = false;
+    for (band_top = 0; band_top < (int16_t)canvas.height; band_top = band_bottom) {
+        uint16_t n = band_rows * canvas.stride;
+        band_bottom = band_top + band_rows;
+        if (band_bottom > (int16_t)canvas.height) {
+            band_bottom = canvas.height;
+            n = (band_bottom - band_top) * canvas.stride;
+        }
+        memset(band_scratch, 0, n);
+        for (i = 0; i < band_count; i++) {
+            band_item_t *item = &band_items[i];
+            if (item->top <= item->bottom && item->top < band_bottom) {
+                band_draw(item);
+            }
+        }
+        // rows are back to back in XRAM, so a band is one write
+        xram_write(canvas.row[band_top], band_scratch, n);
+    }
+    band_stats.frames++;
+    band_stats.items += band_count;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void canvas_record_end(void)
+{
+    if (recording) {
+        band_render();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// A full list is drawn right away, which leaves the buffer cleared and up
+// to date, and the rest of the frame is drawn directly
+// ---------------------------------------------------------------------------
+static band_item_t *band_add(uint8_t kind, uint8_t fill, int16_t top, int16_t bottom)
+{
+    band_item_t *item;
+
+    if (band_count == BAND_MAX_ITEMS) {
+        band_stats.overflows++;
+        band_render();
+        return NULL;
+    }
+    item = &band_items[band_count++];
+    item->kind = kind;
+    item->fill = fill;
+    item->top = top;
+    item->bottom = bottom;
+    return item;
+}
+
+// ---------------------------------------------------------------------------
+// A pixel joins the last item when that is a point list of the same colour
+// with room left and the pixel is within reach of its first one, so dots
+// and circles take an item per ITEM_POINTS_MAX pixels
+// ---------------------------------------------------------------------------
+static bool record_point(uint16_t color, int16_t x, int16_t y)
+{
+    uint8_t fill = pixel_fill(color);
+    band_item_t *item = band_count ? &band_items[band_count - 1] : NULL;
+
+    if (item == NULL || item->kind != ITEM_POINTS || item->fill != fill ||
+        item->u.points.count == ITEM_POINTS_MAX ||
+        (uint16_t)(x - item->u.points.x + 128) > 255 ||
+        (uint16_t)(y - item->u.points.y + 128) > 255) {
+        item = band_add(ITEM_POINTS, fill, y, y);
+        if (item == NULL) {
+            return false;
+        }
+        item->u.points.x = x;
+        item->u.points.y = y;
+        item->u.points.count = 0;
+    }
+    item->u.points.dx[item->u.points.count] = x - item->u.points.x;
+    item->u.points.dy[item->u.points.count] = y - item->u.points.y;
+    item->u.points.count++;
+    if (y < item->top) {
+        item->top = y;
+    }
+    if (y > item->bottom) {
+        item->bottom = y;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static bool record_span(uint16_t color, int16_t x, int16_t y, int16_t w)
+{
+    band_item_t *item = band_add(ITEM_SPAN, pixel_fill(color), y, y);
+
+    if (item == NULL) {
+        return false;
+    }
+    item->u.span.x = x;
+    item->u.span.w = w;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Lines take the stepper of the direct ones. Bands are drawn from the top,
+// so a shallow line that climbs to the right is walked from its right end.
+// ---------------------------------------------------------------------------
+static bool record_line(uint16_t color, int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    band_item_t *item;
+
+    if (y0 > y1) {
+        swap(x0, x1);
+        swap(y0, y1);
+    }
+    if (y1 < 0 || y0 >= (int16_t)canvas.height) { // Clip
+        return true;
+    }
+    item = band_add(ITEM_LINE, pixel_fill(color), y0, y1);
+    if (item == NULL) {
+        return false;
+    }
+    line_start(&item->u.line, x0, y0, x1, y1);
+    if (!item->u.line.steep && item->u.line.minor_step < 0) {
+        line_reverse(&item->u.line);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Vertices are sorted by y (y2 >= y1 >= y0)
+// ---------------------------------------------------------------------------
+static bool record_triangle(uint16_t color, int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                            int16_t x2, int16_t y2)
+{
+    band_item_t *item;
+
+    if (y2 < 0 || y0 >= (int16_t)canvas.height) { // Clip
+        return true;
+    }
+    item = band_add(ITEM_TRIANGLE, pixel_fill(color), y0, y2);
+    if (item == NULL) {
+        return false;
+    }
+    tri_edge_start(&item->u.tri.long_edge, x0, y0, x2, y2);
+    tri_edge_start(&item->u.tri.short_edge, x0, y0, x1, y1);
+    item->u.tri.x1 = x1;
+    item->u.tri.y1 = y1;
+    item->u.tri.x2 = x2;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static bool record_glyph(char chr, int16_t x, int16_t y)
+{
+    band_item_t *item = band_add(ITEM_GLYPH, pixel_fill(textcolor), y, y + 8 * textmultiplier - 1);
+
+    if (item == NULL) {
+        return false;
+    }
+    item->u.glyph.x = x;
+    item->u.glyph.chr = chr;
+    item->u.glyph.mult = textmultiplier;
+    item->u.glyph.bg = (textbgcolor != textcolor);
+    item->u.glyph.bg_fill = pixel_fill(textbgcolor);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Rows top..bottom, already clipped, taking bytes of every image row
+// ---------------------------------------------------------------------------
+static bool record_blit(uint16_t src, uint16_t offset, uint16_t bytes, uint16_t row_bytes,
+                        int16_t top, int16_t bottom)
+{
+    band_item_t *item = band_add(ITEM_BLIT, 0, top, bottom);
+
+    if (item == NULL) {
+        return false;
+    }
+    item->u.blit.src = src;
+    item->u.blit.offset = offset;
+    item->u.blit.bytes = bytes;
+    item->u.blit.row_bytes = row_bytes;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+const band_stats_t *band_render_stats(void)
+{
+    return &band_stats;
+}
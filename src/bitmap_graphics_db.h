@@ -1,66 +1,178 @@
-// ---------------------------------------------------------------------------
-// bitmap_graphics_db.h
-//
-// This library was written by tonyvr
-// and upgraded by WojciechGw for double buffering 
-// to simplify bitmap graphics programming
-// of the RP6502 picocomputer designed by Rumbledethumps.
-//
-// This code is an adaptation of the vga_graphics library written by V. Hunter Adams
-// from Cornell University, for his excellent RP2040 microcontroller programming course.
-//
-// https://github.com/vha3/Hunter-Adams-RP2040-Demos/tree/master/VGA_Graphics/VGA_Graphics_Primitives
-//
-// There doesn't seem to be a copyright or a license associated with his code.
-// I don't care what you do with my version either -- have fun!
-// ---------------------------------------------------------------------------
-
-#ifndef BITMAP_GRAPHICS_DB_H
-#define BITMAP_GRAPHICS_DB_H
-
-#include <stdbool.h>
-#include <stdint.h>
-
-#define swap(a, b) { int16_t t = a; a = b; b = t; }
-
-// For writing text
-#define TABSPACE 4 // number of spaces for a tab
-
-// For accessing the font library
-#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
-
-void init_bitmap_graphics(uint16_t canvas_struct_address,
-                          uint16_t canvas_data_address,
-                          uint8_t  canvas_plane,
-                          uint8_t  canvas_type,
-                          uint16_t canvas_width,
-                          uint16_t canvas_height,
-                          uint8_t  bits_per_pixel);
-uint16_t canvas_width(void);
-uint16_t canvas_height(void);
-uint8_t bits_per_pixel(void);
-
-uint16_t random(uint16_t low_limit, uint16_t high_limit);
-
-void set_cursor(uint16_t x, uint16_t y);
-void set_text_multiplier(uint8_t mult);
-void set_text_color(uint16_t color); // transparent background
-void set_text_colors(uint16_t color, uint16_t background);
-void set_text_wrap(bool w);
-
-void switch_buffer(uint16_t buffer_data_address);
-void erase_buffer(uint16_t buffer_data_address);
-void draw_pixel2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t buffer_data_address);
-void draw_line2buffer(uint16_t color, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t buffer_data_address);
-void draw_vline2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t h, uint16_t buffer_data_address);
-void draw_hline2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t buffer_data_address);
-void draw_rect2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t buffer_data_address);
-void fill_rect2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t buffer_data_address);
-void draw_circle2buffer(uint16_t color, uint16_t x0, uint16_t y0, uint16_t r, uint16_t buffer_data_address);
-void fill_circle2buffer(uint16_t color, uint16_t x0, uint16_t y0, uint16_t r, uint16_t buffer_data_address);
-void draw_rounded_rect2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t buffer_data_address);
-void fill_rounded_rect2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t buffer_data_address);
-void draw_char2buffer(char chr, uint16_t x, uint16_t y, uint16_t buffer_data_address);
-void draw_string2buffer(char * str, uint16_t buffer_data_address);
-
-#endif // BITMAP_GRAPHICS_DB_H
+// ---------------------------------------------------------------------------
+// bitmap_graphics_db.h
+//
+// This library was written by tonyvr
+// and upgraded by WojciechGw for double buffering 
+// to simplify bitmap graphics programming
+// of the RP6502 picocomputer designed by Rumbledethumps.
+//
+// This code is an adaptation of the vga_graphics library written by V. Hunter Adams
+// from Cornell University, for his excellent RP2040 microcontroller programming course.
+//
+// https://github.com/vha3/Hunter-Adams-RP2040-Demos/tree/master/VGA_Graphics/VGA_Graphics_Primitives
+//
+// There doesn't seem to be a copyright or a license associated with his code.
+// I don't care what you do with my version either -- have fun!
+// ---------------------------------------------------------------------------
+
+#ifndef BITMAP_GRAPHICS_DB_H
+#define BITMAP_GRAPHICS_DB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define swap(a, b) { int16_t t = a; a = b; b = t; }
+
+// For writing text
+#define TABSPACE 4 // number of spaces for a tab
+
+// For accessing the font library
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+
+#define CANVAS_MAX_HEIGHT 480
+
+// RIA ports: the library reads XRAM through port 0 and writes through
+// port 1, and sets the step of a port it uses to 1. The calls below are
+// tagged with the ports they may move. A [1] call leaves port 0 alone, so
+// a caller can keep reading a stream through it across the call. Pixels
+// at 1, 2 and 4bpp are read back when they leave the cache, which makes
+// the drawing calls [0 1] at those depths and [1] at 8 and 16bpp.
+
+// Drawing context: the buffer being drawn into and the XRAM address where
+// each of its rows starts, so primitives look rows up instead of
+// multiplying by the stride
+typedef struct {
+    uint16_t data;                      // target buffer
+    uint16_t width;
+    uint16_t height;
+    uint16_t stride;                    // bytes per row
+    uint8_t  bpp;
+    uint8_t  bpp_mode;
+    uint8_t  plane_mask;                // pixel bits drawing may change
+    uint8_t  plane_byte_mask;           // the same for every pixel of a byte
+    uint16_t row[CANVAS_MAX_HEIGHT];
+} canvas_t;
+
+// Pixels at 1, 2 and 4bpp are combined in a cache of this many bytes and
+// reach XRAM when their slot is reused or the cache is flushed
+#define PIXEL_CACHE_SIZE 64 // power of two
+
+// Lines with major / minor of at least this are drawn as runs of spans,
+// steeper ones pixel by pixel
+#ifndef LINE_RUN_SLOPE
+#define LINE_RUN_SLOPE 2
+#endif
+
+// Band renderer: a frame recorded as a display list is rasterized into RAM
+// BAND_BYTES at a time (at most BAND_MAX_ROWS rows) and streamed to XRAM.
+// A list item is 34 bytes, so the list takes about 3.2 KB of RAM.
+#define BAND_BYTES 1280
+#define BAND_MAX_ROWS 32
+#define BAND_MAX_ITEMS 96
+
+typedef struct {
+    uint32_t frames;
+    uint32_t items;     // display list entries over all frames
+    uint16_t overflows; // frames whose list filled up and went direct
+} band_stats_t;
+
+typedef struct {
+    uint32_t pixels;    // drawn through the cache
+    uint32_t merged;    // of those, into a byte that was already cached
+    uint32_t written;   // bytes written back to XRAM
+} pixel_cache_stats_t;
+
+void init_bitmap_graphics(uint16_t canvas_struct_address,
+                          uint16_t canvas_data_address,
+                          uint8_t  canvas_plane,
+                          uint8_t  canvas_type,
+                          uint16_t canvas_width,
+                          uint16_t canvas_height,
+                          uint8_t  bits_per_pixel);
+uint16_t canvas_width(void);
+uint16_t canvas_height(void);
+uint8_t bits_per_pixel(void);
+// Show the canvas x, y pixels from the top left of the screen, the picture
+// moves without being drawn again (init_bitmap_graphics puts it at 0, 0
+// or centres a 16bpp canvas)
+void canvas_move(int16_t x, int16_t y);                                  // [0]
+// Show and draw only the top left width x height pixels of the canvas, at
+// most the size init_bitmap_graphics set up. A small canvas moved around
+// by canvas_move costs only its own bytes to clear. Redraw every buffer
+// after a resize.
+bool canvas_resize(uint16_t width, uint16_t height);                     // [0 1]
+// Change the canvas type and size at the same colour depth, on the buffer
+// shown, without the checks and messages of init_bitmap_graphics (the
+// size must suit the type). Redraw every buffer after a switch.
+bool canvas_switch(uint8_t canvas_type, uint16_t width, uint16_t height); // [0 1]
+
+const canvas_t *canvas_context(void);
+// Draw into buffer_data_address. The *2buffer calls retarget by themselves
+// when they are given another buffer, which rebuilds the row table.
+void canvas_target(uint16_t buffer_data_address);
+// The buffer the canvas shows (init_bitmap_graphics, then switch_buffer)
+uint16_t canvas_buffer(void);
+// Write the cached pixels to XRAM. switch_buffer, switch_palette and the
+// erase calls do this, call it when a shown buffer is drawn on.
+void canvas_flush(void);                                                 // [0 1]
+const pixel_cache_stats_t *pixel_cache_stats(void);
+// Record the drawing calls that follow instead of drawing them, then
+// canvas_record_end writes the whole buffer once, band by band, so it
+// needs no erase. Pixels, lines, spans, triangles, text, blits and the
+// shapes built from them are recorded, pixels near each other batched
+// into one item. The pixels are the ones drawing directly would set.
+// Returns false (draw directly) at 8 and 16bpp or with a plane mask set.
+bool canvas_record_begin(uint16_t buffer_data_address);
+void canvas_record_end(void);                                            // [0 1]
+const band_stats_t *band_render_stats(void);
+
+uint16_t random(uint16_t low_limit, uint16_t high_limit);
+
+void set_cursor(uint16_t x, uint16_t y);
+void set_text_multiplier(uint8_t mult);
+void set_text_color(uint16_t color); // transparent background
+void set_text_colors(uint16_t color, uint16_t background);
+void set_text_wrap(bool w);
+
+void switch_buffer(uint16_t buffer_data_address);                        // [0 1]
+void erase_buffer(uint16_t buffer_data_address);                         // [1]
+// Copy a whole buffer (port 0 reads src, port 1 writes)
+void copy_buffer(uint16_t src_data_address, uint16_t buffer_data_address); // [0 1]
+// Copy a packed image of w x h pixels from XRAM to x, y (port 0 walks the
+// image, port 1 the rows). x and w are rounded down to whole bytes.
+void blit2buffer(uint16_t xram_image_address, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                 uint16_t buffer_data_address);                          // [0 1]
+// Bitplanes (2bpp and 4bpp): drawing only changes the pixel bits in mask,
+// so frames can be drawn into separate planes of one buffer and shown by
+// switching to a palette that only looks at one plane
+void set_plane_mask(uint8_t mask);
+void erase_planes2buffer(uint8_t mask, uint16_t buffer_data_address);    // [0 1]
+void switch_palette(uint16_t xram_palette_address);                      // [0 1]
+void draw_pixel2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t buffer_data_address);
+void draw_line2buffer(uint16_t color, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t buffer_data_address);
+void draw_vline2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t h, uint16_t buffer_data_address);
+void draw_hline2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t buffer_data_address);
+void draw_rect2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t buffer_data_address);
+void fill_rect2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t buffer_data_address);
+void draw_circle2buffer(uint16_t color, uint16_t x0, uint16_t y0, uint16_t r, uint16_t buffer_data_address);
+void fill_circle2buffer(uint16_t color, uint16_t x0, uint16_t y0, uint16_t r, uint16_t buffer_data_address);
+void draw_rounded_rect2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t buffer_data_address);
+void fill_rounded_rect2buffer(uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t buffer_data_address);
+void fill_triangle2buffer(uint16_t color, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t buffer_data_address);
+// Text. Digits and '-' at the default size draw from a strip of glyph rows
+// made at init, a row at a time instead of a pixel at a time.
+void draw_char2buffer(char chr, uint16_t x, uint16_t y, uint16_t buffer_data_address);
+void draw_string2buffer(char * str, uint16_t buffer_data_address);
+// Write value in decimal to str (FORMAT_INT_BYTES fit any value) and
+// return the length. It needs no libc formatting and no divide, which
+// makes it cheap per call. The demo draws all its numbers with these, so
+// sprintf is not linked; printf still is, for the console.
+#define FORMAT_INT_BYTES 7
+uint8_t format_int(char *str, int16_t value);
+// The same for 32-bit counters
+#define FORMAT_ULONG_BYTES 11
+uint8_t format_ulong(char *str, uint32_t value);
+// Draw value at the cursor, like draw_string2buffer
+void draw_int2buffer(int16_t value, uint16_t buffer_data_address);
+
+#endif // BITMAP_GRAPHICS_DB_H
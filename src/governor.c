@@ -0,0 +1,108 @@
+// ---------------------------------------------------------------------------
+// governor.c
+//
+// Frame budget governor: trades detail for frame rate.
+// ---------------------------------------------------------------------------
+
+#include <rp6502.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "governor.h"
+
+governor_t governor;
+
+static uint8_t window_frames = 0;
+static uint16_t window_ticks = 0;
+static uint8_t last_vsync = 0;
+
+static uint8_t hold = GOVERNOR_HOLD_WINDOWS;
+static uint8_t headroom_windows = 0;
+static bool just_restored = false;
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void governor_init(uint8_t target_ticks, uint8_t max_level)
+{
+    governor.target_ticks = target_ticks;
+    governor.max_level = max_level;
+    governor.window_ticks = 0;
+    governor.drops = 0;
+    governor.restores = 0;
+    governor_restore();
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void governor_reset(void)
+{
+    window_frames = 0;
+    window_ticks = 0;
+    last_vsync = RIA.vsync;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void governor_restore(void)
+{
+    governor.level = GOVERNOR_FULL;
+    hold = GOVERNOR_HOLD_WINDOWS;
+    headroom_windows = 0;
+    just_restored = false;
+    governor_reset();
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool governor_frame_rendered(void)
+{
+    uint8_t vsync = RIA.vsync;
+    uint16_t budget;
+
+    window_ticks += (uint8_t)(vsync - last_vsync);
+    last_vsync = vsync;
+    if (++window_frames < GOVERNOR_WINDOW_FRAMES) {
+        return false;
+    }
+
+    budget = (uint16_t)governor.target_ticks * GOVERNOR_WINDOW_FRAMES;
+    governor.window_ticks = window_ticks;
+    window_frames = 0;
+    window_ticks = 0;
+
+    if (governor.window_ticks > budget) {
+        headroom_windows = 0;
+        if (just_restored) {
+            // that level did not fit after all, wait longer next time
+            just_restored = false;
+            if (hold < GOVERNOR_MAX_HOLD) {
+                hold *= 2;
+            }
+        }
+        if (governor.level < governor.max_level) {
+            governor.level++;
+            governor.drops++;
+            return true;
+        }
+        return false;
+    }
+
+    if (just_restored) {
+        // it fits, so the scene got lighter: be quicker again next time
+        just_restored = false;
+        if (hold > GOVERNOR_HOLD_WINDOWS) {
+            hold /= 2;
+        }
+    }
+    if (governor.window_ticks * 4 > budget * 3) {
+        headroom_windows = 0;
+        return false;
+    }
+    if (governor.level > GOVERNOR_FULL && ++headroom_windows >= hold) {
+        headroom_windows = 0;
+        just_restored = true;
+        governor.level--;
+        governor.restores++;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,56 @@
+// ---------------------------------------------------------------------------
+// governor.h
+//
+// Frame budget governor. Frame times are summed over windows of
+// GOVERNOR_WINDOW_FRAMES frames and held against a target. A window over
+// budget drops the detail one level at once. A level is only given back
+// after GOVERNOR_HOLD_WINDOWS windows in a row that had a quarter of the
+// budget to spare. If the restored level goes over budget straight away,
+// the hold doubles (up to GOVERNOR_MAX_HOLD), so a scene that sits on the
+// edge does not flip between two levels every window. A restored level
+// that fits halves it again.
+//
+// The levels, each including the ones before:
+//
+//   GOVERNOR_FULL            everything
+//   GOVERNOR_PLAIN_TEXT      no 2x/3x text, no coordinate overlay
+//   GOVERNOR_SIMPLE_MARKERS  dots for vertex labels, bare buffer indicator
+//   GOVERNOR_LOW_RES         a lower resolution canvas
+// ---------------------------------------------------------------------------
+
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GOVERNOR_FULL 0
+#define GOVERNOR_PLAIN_TEXT 1
+#define GOVERNOR_SIMPLE_MARKERS 2
+#define GOVERNOR_LOW_RES 3
+
+#define GOVERNOR_WINDOW_FRAMES 8
+#define GOVERNOR_HOLD_WINDOWS 4
+#define GOVERNOR_MAX_HOLD 32
+
+typedef struct {
+    uint8_t  level;
+    uint8_t  max_level;
+    uint8_t  target_ticks;      // per frame
+    uint16_t window_ticks;      // of the last finished window
+    uint16_t drops;             // level changes down ...
+    uint16_t restores;          // ... and back up
+} governor_t;
+
+extern governor_t governor;
+
+// Aim for target_ticks per frame, never going past max_level
+void governor_init(uint8_t target_ticks, uint8_t max_level);
+// Start the window in progress from now (after a pause), the level is kept
+void governor_reset(void);
+// Back to full detail
+void governor_restore(void);
+// Count a finished frame. Returns true when the level changed.
+bool governor_frame_rendered(void);
+
+#endif // GOVERNOR_H
@@ -0,0 +1,85 @@
+// ---------------------------------------------------------------------------
+// input.c
+//
+// Change-driven keyboard input with press/release events.
+// ---------------------------------------------------------------------------
+
+#include <rp6502.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "input.h"
+#include "xram_io.h"
+
+static uint16_t keyboard_xram = 0xFF10;
+static uint8_t keystates[KEYBOARD_BYTES] = {0};
+
+static input_event_t queue[INPUT_QUEUE_SIZE];
+static uint8_t queue_head = 0; // next event to take
+static uint8_t queue_tail = 0; // next free slot
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void input_init(uint16_t xram_addr)
+{
+    keyboard_xram = xram_addr;
+    xregn(0, 0, 0, 1, keyboard_xram);
+
+    // start from the current state so held keys do not fire
+    xram_read(keystates, keyboard_xram, KEYBOARD_BYTES);
+    queue_head = queue_tail = 0;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void input_poll(void)
+{
+    uint8_t i, j;
+
+    RIA.addr0 = keyboard_xram;
+    RIA.step0 = 1;
+    for (i = 0; i < KEYBOARD_BYTES; i++) {
+        uint8_t new_keys = RIA.rw0;
+        uint8_t changed = new_keys ^ keystates[i];
+
+        if (i == 0) {
+            // codes 0-3 are status bits, not keys
+            changed &= 0xF0;
+        }
+        if (changed) {
+            for (j = 0; j < 8; j++) {
+                if (!(changed & (1 << j))) {
+                    continue;
+                }
+                if ((uint8_t)(queue_tail - queue_head) < INPUT_QUEUE_SIZE) {
+                    input_event_t *event = &queue[queue_tail++ & (INPUT_QUEUE_SIZE - 1)];
+                    event->code = (i << 3) + j;
+                    event->pressed = (new_keys & (1 << j)) != 0;
+                } else {
+                    // no room: keep the old state, the next poll sees the change again
+                    new_keys ^= 1 << j;
+                }
+            }
+        }
+        keystates[i] = new_keys;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool input_next_event(input_event_t *event)
+{
+    if (queue_head == queue_tail) {
+        return false;
+    }
+    *event = queue[queue_head++ & (INPUT_QUEUE_SIZE - 1)];
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// keystates[code>>3] gets contents from correct byte in array
+// 1 << (code&7) moves a 1 into proper position to mask with byte contents
+// ---------------------------------------------------------------------------
+bool input_key_down(uint8_t code)
+{
+    return (keystates[code >> 3] & (1 << (code & 7))) != 0;
+}
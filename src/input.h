@@ -0,0 +1,37 @@
+// ---------------------------------------------------------------------------
+// input.h
+//
+// Change-driven keyboard input.
+//
+// The RIA keeps a 256-bit bitmask of pressed HID keys in XRAM. The mapping
+// is set up once; each poll streams the 32 bytes through port 0 with
+// auto-increment, compares them with the previous state in the same pass
+// and queues a press or release event for every key that changed.
+// ---------------------------------------------------------------------------
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 256 bytes HID code max, stored in 32 uint8
+#define KEYBOARD_BYTES 32
+#define INPUT_QUEUE_SIZE 8 // power of two
+
+typedef struct {
+    uint8_t code;     // HID key code (see usb_hid_keys.h)
+    bool    pressed;  // false for a release
+} input_event_t;
+
+// Map the keyboard bitmask to KEYBOARD_BYTES of XRAM at xram_addr
+void input_init(uint16_t xram_addr);
+// Read the keyboard and queue events for keys that changed [port 0]. A
+// change that does not fit in the queue is left for a later poll.
+void input_poll(void);
+// Take the oldest queued event, false when there is none
+bool input_next_event(input_event_t *event);
+// True while the key is held (as of the last poll)
+bool input_key_down(uint8_t code);
+
+#endif // INPUT_H
@@ -0,0 +1,68 @@
+// ---------------------------------------------------------------------------
+// lz.c
+//
+// Unpacker for assets compressed by tools/lz.py.
+// ---------------------------------------------------------------------------
+
+#include <rp6502.h>
+#include <stdint.h>
+#include "lz.h"
+
+#define LZ_MIN_MATCH 3
+
+// ---------------------------------------------------------------------------
+// Little-endian read through port 0 (step0 must be 1)
+// ---------------------------------------------------------------------------
+static uint16_t read_word(void)
+{
+    uint16_t lo = RIA.rw0;
+    return lo | ((uint16_t)RIA.rw0 << 8);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint16_t lz_length_xram(uint16_t src)
+{
+    RIA.addr0 = src;
+    RIA.step0 = 1;
+    if (RIA.rw0 != 'L' || RIA.rw0 != 'Z') {
+        return 0;
+    }
+    return read_word();
+}
+
+// ---------------------------------------------------------------------------
+// The packed stream is read through port 0 and the output written through
+// port 1. A back-reference borrows port 0 to read the output written
+// earlier, then puts it back on the packed stream.
+// ---------------------------------------------------------------------------
+uint16_t lz_unpack_xram(uint16_t src, uint16_t dst)
+{
+    uint16_t length = lz_length_xram(src);
+    uint16_t done = 0;
+
+    RIA.addr1 = dst;
+    RIA.step1 = 1;
+    while (done < length) {
+        uint8_t token = RIA.rw0;
+        uint8_t count;
+        if (token & 0x80) {
+            uint16_t offset = read_word();
+            uint16_t resume = RIA.addr0;
+            count = (token & 0x7F) + LZ_MIN_MATCH;
+            RIA.addr0 = dst + done - offset;
+            done += count;
+            while (count--) {
+                RIA.rw1 = RIA.rw0;
+            }
+            RIA.addr0 = resume;
+        } else {
+            count = token + 1;
+            done += count;
+            while (count--) {
+                RIA.rw1 = RIA.rw0;
+            }
+        }
+    }
+    return length;
+}
@@ -0,0 +1,25 @@
+// ---------------------------------------------------------------------------
+// lz.h
+//
+// Unpacker for assets compressed by tools/lz.py, so the ROM carries (and
+// the monitor uploads) fewer bytes. Layout (little-endian):
+//
+//   'L' 'Z' uint16 unpacked_length
+//   tokens, until unpacked_length bytes are produced:
+//     0nnnnnnn                  n+1 literal bytes follow
+//     1nnnnnnn  uint16 offset   copy n+3 bytes from offset bytes back
+//
+// The destination must not overlap the packed data still to be read.
+// ---------------------------------------------------------------------------
+
+#ifndef LZ_H
+#define LZ_H
+
+#include <stdint.h>
+
+// Unpacked length of the LZ data at XRAM src, 0 if there is none
+uint16_t lz_length_xram(uint16_t src);
+// XRAM to XRAM. Uses both RIA ports. Returns the unpacked length.
+uint16_t lz_unpack_xram(uint16_t src, uint16_t dst);
+
+#endif // LZ_H
@@ -1,440 +1,1052 @@
-// Simple rotating 3D cube
-//
-// Original code by Grzegorz Rakoczy
-// fun stuff with coordinates caching and double buffering 
-// added by WojciechGw
-//
-
-#include <rp6502.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <stdbool.h>
-#include <stdint.h>
-#include <inttypes.h>
-#include "colors.h"
-#include "usb_hid_keys.h"
-#include "bitmap_graphics_db.h"
-
-// #define HIRES
-#define NUM_MODES 4
-
-// Screen related
-//
-#ifdef HIRES
-    #define SCALE 48
-    #define SCREEN_WIDTH 640
-    #define SCREEN_HEIGHT 360
-    #define OFFSET_X 60
-    #define OFFSET_Y 0
-    #define NUM_POINTS 270
-#else
-    #define SCALE 96
-    #define SCREEN_WIDTH 320
-    #define SCREEN_HEIGHT 240
-    #define OFFSET_X 30
-    #define OFFSET_Y 0
-    #define NUM_POINTS 270
-#endif
-
-// for double buffering
-uint16_t buffers[2];
-uint8_t active_buffer = 0;
-int16_t distance = 1000; // for perspective calculations
-char *buf[] = {"                                                                  "};
-
-bool paused = true;
-bool show_indicators = false;
-bool show_vertex_coordinates = false;
-bool first_run = true;
-
-// Keyboard related
-//
-// XRAM locations
-#define KEYBOARD_INPUT 0xFF10 // KEYBOARD_BYTES of bitmask data
-// 256 bytes HID code max, stored in 32 uint8
-#define KEYBOARD_BYTES 32
-uint8_t keystates[KEYBOARD_BYTES] = {0};
-// keystates[code>>3] gets contents from correct byte in array
-// 1 << (code&7) moves a 1 into proper position to mask with byte contents
-// final & gives 1 if key is pressed, 0 if not
-#define key(code) (keystates[code >> 3] & (1 << (code & 7)))
-
-// Fixed-point arithmetics
-//
-// Precompute sine and cosine values for rotation
-int16_t sine_values[NUM_POINTS];
-int16_t cosine_values[NUM_POINTS];
-int16_t cube_vertices_precalculated[NUM_POINTS][8][3];
-uint32_t cube_position = 0;
-bool calculations_completed = false;
-
-// Constants for fixed-point trigonometry
-enum {cA1 = 3370945099UL, cB1 = 2746362156UL, cC1 = 292421UL};
-enum {n = 13, p = 32, q = 31, r = 3, a = 12};
-
-// Function to calculate fixed-point sine
-// https://www.nullhardware.com/blog/fixed-point-sine-and-cosine-for-embedded-systems/
-//
-int16_t fpsin(int16_t i) {
-    i <<= 1;
-    uint8_t c = i < 0; // Set carry for output pos/neg
-
-    if(i == (i | 0x4000)) // Flip input value to corresponding value in range [0..8192]
-        i = (1 << 15) - i;
-    i = (i & 0x7FFF) >> 1;
-
-    uint32_t y = (cC1 * ((uint32_t)i)) >> n;
-    y = cB1 - (((uint32_t)i * y) >> r);
-    y = (uint32_t)i * (y >> n);
-    y = (uint32_t)i * (y >> n);
-    y = cA1 - (y >> (p - q));
-    y = (uint32_t)i * (y >> n);
-    y = (y + (1UL << (q - a - 1))) >> (q - a); // Rounding
-
-    return c ? -y : y;
-}
-
-// Function to calculate fixed-point cosine
-#define fpcos(i) fpsin((int16_t)(((uint16_t)(i)) + 8192U))
-
-// Cube vertices in 3D space (8 corners of a cube)
-int16_t cube_vertices[8][3] = {
-    {-4096, -4096, -4096}, {4096, -4096, -4096}, {4096, 4096, -4096}, {-4096, 4096, -4096},  // Back face
-    {-4096, -4096,  4096}, {4096, -4096,  4096}, {4096, 4096,  4096}, {-4096, 4096,  4096}   // Front face
-};
-
-void precompute_sin_cos() {
-    int16_t angle_step = 32768 / NUM_POINTS; // 32768 is 2^15, representing 2*pi
-
-    for (int i = 0; i < NUM_POINTS; i++) {
-        sine_values[i] = fpsin(i * angle_step);
-        cosine_values[i] = fpcos(i * angle_step);
-    }
-}
-
-void WaitForAnyKey(){
-
-    bool handled_key = true;
-    while (1){
-        xregn( 0, 0, 0, 1, KEYBOARD_INPUT);
-        RIA.addr0 = KEYBOARD_INPUT;
-        RIA.step0 = 0;
-        // fill the keystates bitmask array
-        for (uint8_t i = 0; i < KEYBOARD_BYTES; i++) {
-            uint8_t j, new_keys;
-            RIA.addr0 = KEYBOARD_INPUT + i;
-            new_keys = RIA.rw0;
-            // check for change in any and all keys
-            for (j = 0; j < 8; j++) {
-                uint8_t new_key = (new_keys & (1<<j));
-                //if ((((i<<3)+j)>3) && (new_key != (keystates[i] & (1<<j)))) {
-                    // printf( "key %d %s\n", ((i<<3)+j), (new_key ? "pressed" : "released"));
-                //}
-            }
-            keystates[i] = new_keys;
-        }
-        // check for a key down
-        if (!(keystates[0] & 1)) {
-            if (!handled_key) { // handle only once per single keypress
-                // handle the keystrokes
-                handled_key = true;
-                break;
-            }
-        } else { // no keys down
-            handled_key = false;
-        }
-    }
-}
-
-// Recalculate coordinates for perspective view
-//
-/*
-    int16_t addPerspective(int32_t coordinate, int32_t z, int32_t distance){
-    int32_t denominator = distance + z;
-    int32_t scaleFactor = 1000;
-    int32_t scaled_distance = distance * scaleFactor;
-    int32_t ratio = scaled_distance / denominator;
-    return (int16_t)((coordinate * ratio) / scaleFactor);
-}
-*/
-
-// Draw the cube by connecting the vertices with lines
-void drawCube(int angleX, int angleY, int angleZ, int16_t color, uint8_t mode, uint32_t position, uint16_t buffer_data_address) {
-
-    int16_t x2d[8], y2d[8], z2d[8];
-    int16_t x = 0;
-    int16_t y = 0;
-    int16_t z = 0;
-
-    // Rotate and project all vertices
-    for (uint8_t i = 0; i < 8; i++) {
-
-        if(!calculations_completed || first_run){
-
-            int16_t vertex[3] = {cube_vertices[i][0], cube_vertices[i][1], cube_vertices[i][2]};
-            x = vertex[0];
-            y = vertex[1];
-            z = vertex[2];
-
-            // rotate y
-            int16_t rotx = ((long)x * (long)cosine_values[angleY] + (long)z * (long)sine_values[angleY])>> 12;
-            int16_t roty = (long)y;
-            int16_t rotz = ((long)z * (long)cosine_values[angleY] - (long)x * (long)sine_values[angleY])>> 12;
-            // rotate x
-            int16_t rotxx = (long)rotx;
-            int16_t rotyy = ((long)roty * (long)cosine_values[angleX] - (long)rotz * (long)sine_values[angleX])>> 12;
-            int16_t rotzz = ((long)roty * (long)sine_values[angleX] + (long)rotz * (long)cosine_values[angleX])>> 12;
-            // rotate z
-            int16_t rotxxx = ((long)rotxx * (long)cosine_values[angleZ] - (long)rotyy * (long)sine_values[angleZ])>> 12;
-            int16_t rotyyy = ((long)rotxx * (long)sine_values[angleZ] + (long)rotyy * (long)cosine_values[angleZ])>> 12;
-            int16_t rotzzz = (long)rotzz;
-
-            // add perspective
-            int16_t rotxxx_p = rotxxx; // addPerspective((int32_t)rotxxx, (int32_t)rotzzz, (int32_t)distance);
-            int16_t rotyyy_p = rotyyy; // addPerspective((int32_t)rotyyy, (int32_t)rotzzz, (int32_t)distance);
-
-            // send to center of the screen (with optional offset)
-            x = (rotxxx_p / SCALE) + SCREEN_WIDTH / 2 + OFFSET_X;
-            y = (rotyyy_p / SCALE) + SCREEN_HEIGHT / 2 + OFFSET_Y;
-            z = (rotzzz / SCALE);
-
-            cube_vertices_precalculated[position][i][0] = x;
-            cube_vertices_precalculated[position][i][1] = y;
-            cube_vertices_precalculated[position][i][2] = z;
-
-        } else {
-
-            x = cube_vertices_precalculated[position][i][0];
-            y = cube_vertices_precalculated[position][i][1];
-            z = cube_vertices_precalculated[position][i][2];
-
-        }
-
-        x2d[i] = x;
-        y2d[i] = y;
-        z2d[i] = z;
-        
-    }
-
-    // show additional infos
-    if (show_vertex_coordinates){
-        for (uint8_t i = 0; i < 8; i++) {
-            // set_cursor(10,10);
-            // sprintf(*buf,"distance: %d", distance);
-            // draw_string2buffer(*buf, buffer_data_address);
-            set_cursor(20, 40 + i * 10);
-            sprintf(*buf,"%d (%d,%d,%d)", i, x2d[i], y2d[i], z2d[i]);
-            draw_string2buffer(*buf, buffer_data_address);
-        }
-    }
-
-    if(calculations_completed || first_run){
-        // Connect the vertices with lines to draw the cube (front and back faces)
-        if (mode == 0 || mode > 3) {
-            draw_line2buffer(color, x2d[0], y2d[0], x2d[1], y2d[1], buffer_data_address);
-            draw_line2buffer(color, x2d[1], y2d[1], x2d[2], y2d[2], buffer_data_address);
-            draw_line2buffer(color, x2d[2], y2d[2], x2d[3], y2d[3], buffer_data_address);
-            draw_line2buffer(color, x2d[3], y2d[3], x2d[0], y2d[0], buffer_data_address);
-            draw_line2buffer(color, x2d[4], y2d[4], x2d[5], y2d[5], buffer_data_address);
-            draw_line2buffer(color, x2d[5], y2d[5], x2d[6], y2d[6], buffer_data_address);
-            draw_line2buffer(color, x2d[6], y2d[6], x2d[7], y2d[7], buffer_data_address);
-            draw_line2buffer(color, x2d[7], y2d[7], x2d[4], y2d[4], buffer_data_address);
-            draw_line2buffer(color, x2d[0], y2d[0], x2d[4], y2d[4], buffer_data_address);
-            draw_line2buffer(color, x2d[1], y2d[1], x2d[5], y2d[5], buffer_data_address);
-            draw_line2buffer(color, x2d[2], y2d[2], x2d[6], y2d[6], buffer_data_address);
-            draw_line2buffer(color, x2d[3], y2d[3], x2d[7], y2d[7], buffer_data_address);
-            // additional cross to indicate front side
-            if(mode == 4){
-                draw_line2buffer(color, x2d[2], y2d[2], x2d[7], y2d[7], buffer_data_address);
-                draw_line2buffer(color, x2d[3], y2d[3], x2d[6], y2d[6], buffer_data_address);
-            }
-        }
-
-        if (mode == 1) {
-            for(int v = 0; v < 8; v++){
-                draw_pixel2buffer(color, x2d[v], y2d[v], buffer_data_address);
-            }
-        }
-
-        if (mode > 1){
-            for(int v = 0; v < 8; v++){
-                // if(z2d[v] <= 0) draw_circle2buffer(color, x2d[v], y2d[v], 3, buffer_data_address);
-                set_cursor(x2d[v] + 3, y2d[v] + 3);
-                // sprintf(*buf,"%d(%d,%d,%d)", v, x2d[v], y2d[v], z2d[v]);
-                set_text_multiplier((z2d[v] < 0) ? ((z2d[v] < -90) ? 3 : 2) : 1);
-                sprintf(*buf,"%d", v);
-                draw_string2buffer(*buf, buffer_data_address);
-                set_text_multiplier(1);
-            }
-        }
-    }
-}
-
-int main() {
-    
-    // Precompute sine and cosine values
-    precompute_sin_cos();
-
-    bool handled_key = false;
-    uint8_t mode = 0;
-    uint8_t i = 0;
-    buffers[0] = 0x0000;
-#ifdef HIRES
-    buffers[1] = 0x7080;
-#else
-    buffers[1] = 0x2580;
-#endif
-    erase_buffer(buffers[0]);
-    erase_buffer(buffers[1]);
-
-#ifdef HIRES
-    init_bitmap_graphics(0xFF00, buffers[0], 0, 4, SCREEN_WIDTH, SCREEN_HEIGHT, 1);
-#else
-    init_bitmap_graphics(0xFF00, buffers[0], 0, 1, SCREEN_WIDTH, SCREEN_HEIGHT, 1);
-#endif
-
-    // force 1st buffer
-    active_buffer = 0;
-    switch_buffer(buffers[active_buffer]);
-
-    // start angles
-    int start_angleX = 30, start_angleY = 30, start_angleZ = 15;
-    cube_position = 0;
-    drawCube(start_angleX, start_angleY, start_angleZ, WHITE, mode, cube_position, buffers[active_buffer]);
-    int angleX = start_angleX;
-    int angleY = start_angleY;
-    int angleZ = start_angleZ;
-    mode = 1;
-
-    set_text_multiplier(4);
-    set_cursor(10, 10);
-    draw_string2buffer("3D cube", buffers[active_buffer]);
-    set_text_multiplier(1);
-
-    set_cursor(10, SCREEN_HEIGHT - 60);
-    draw_string2buffer("[SPACE] start/stop", buffers[active_buffer]);
-    set_cursor(10, SCREEN_HEIGHT - 50);
-    draw_string2buffer("[M]     cycle thru drawing modes", buffers[active_buffer]);
-    set_cursor(10, SCREEN_HEIGHT - 40);
-    draw_string2buffer("[B]     show/hide buffer indicator", buffers[active_buffer]);
-    set_cursor(10, SCREEN_HEIGHT - 30);
-    draw_string2buffer("[ESC]   exit", buffers[active_buffer]);
-
-    set_cursor(10, SCREEN_HEIGHT - 10);
-    draw_string2buffer("PRESS ANY KEY TO START", buffers[active_buffer]);
-    WaitForAnyKey();
-
-    while (true) {
-
-        if(!paused || first_run){
-           // Update rotation angles
-            angleX = (angleX + (360 / NUM_POINTS)) % NUM_POINTS;
-            angleY = (angleY + (360 / NUM_POINTS)) % NUM_POINTS;
-            angleZ = (angleZ + (360 / NUM_POINTS)) % NUM_POINTS;
-            if(angleX == start_angleX && angleY == start_angleY && angleZ == start_angleZ)
-            {
-                if(!calculations_completed){
-                    calculations_completed = true;
-                    first_run = false;
-                    paused = false;
-                    mode = 0;
-                    // printf("number of calculated cube positions: %lu\n",cube_position + 1);
-                }
-                cube_position = 0;
-            } else {
-                cube_position++;
-            }
-            // screen double buffering magic
-            // draw on inactive buffer
-            erase_buffer(buffers[!active_buffer]);
-            drawCube(angleX, angleY, angleZ, WHITE, mode, cube_position, buffers[!active_buffer]);
-
-            if(!calculations_completed){
-                set_cursor(0,15);
-                draw_string2buffer("PRECOMPUTING COORDINATES, PLEASE WAIT ...", buffers[!active_buffer]);
-                draw_rect2buffer(WHITE, 0, 0, (NUM_POINTS) + 4                  , 10, buffers[!active_buffer]);
-                fill_rect2buffer(WHITE, 2, 2, (NUM_POINTS) - (cube_position + 1),  6, buffers[!active_buffer]);
-            }
-            if(show_indicators){
-                draw_circle2buffer(WHITE, (active_buffer ? SCREEN_WIDTH - 20 : 20), 20, 8, buffers[!active_buffer]);
-                set_cursor((active_buffer ? SCREEN_WIDTH - 22 : 18), 17);
-                draw_string2buffer((active_buffer ? "0" : "1"), buffers[!active_buffer]);
-            }
-           
-            // switch to updated buffer
-            switch_buffer(buffers[!active_buffer]);
-            // switch active buffer index for next loop
-            active_buffer = !active_buffer;
-        }
-
-        xregn( 0, 0, 0, 1, KEYBOARD_INPUT);
-        RIA.addr0 = KEYBOARD_INPUT;
-        RIA.step0 = 0;
-
-        // fill the keystates bitmask array
-        for (uint8_t i = 0; i < KEYBOARD_BYTES; i++) {
-            uint8_t j, new_keys;
-            RIA.addr0 = KEYBOARD_INPUT + i;
-            new_keys = RIA.rw0;
-            // check for change in any and all keys
-            for (j = 0; j < 8; j++) {
-                uint8_t new_key = (new_keys & (1<<j));
-                //if ((((i<<3)+j)>3) && (new_key != (keystates[i] & (1<<j)))) {
-                    // printf( "key %d %s\n", ((i<<3)+j), (new_key ? "pressed" : "released"));
-                //}
-            }
-            keystates[i] = new_keys;
-        }
-
-        // check for a key down
-        if (!(keystates[0] & 1)) {
-            if (!handled_key) { // handle only once per single keypress
-                // handle the keystrokes
-                if (key(KEY_SPACE)) {
-                    paused = !paused;
-                    if(paused){
-                        set_text_multiplier(4);
-                        set_cursor(10, 10);
-                        draw_string2buffer("3D cube", buffers[active_buffer]);
-                        set_text_multiplier(1);
-                        set_cursor(10, SCREEN_HEIGHT - 60);
-                        draw_string2buffer("[SPACE] start/stop", buffers[active_buffer]);
-                        set_cursor(10, SCREEN_HEIGHT - 50);
-                        draw_string2buffer("[M]     cycle thru drawing modes", buffers[active_buffer]);
-                        set_cursor(10, SCREEN_HEIGHT - 40);
-                        draw_string2buffer("[B]     show/hide buffer indicator", buffers[active_buffer]);
-                        set_cursor(10, SCREEN_HEIGHT - 30);
-                        draw_string2buffer("[ESC]   exit", buffers[active_buffer]);
-                        set_cursor(10, SCREEN_HEIGHT - 10);
-                        draw_string2buffer("Press SPACE to continue", buffers[active_buffer]);
-                    }
-                }
-                if (key(KEY_B)) {
-                    show_indicators = !show_indicators;
-                }
-                if (key(KEY_M)) {
-                    mode = ((mode + 1) > NUM_MODES ? 0 : (mode + 1));
-                }
-                if (key(KEY_C)) {
-                    show_vertex_coordinates = !show_vertex_coordinates;
-                }
-                if (key(KEY_UP)) {
-                    distance = ((distance - 50) < 100 ? 100 : (distance - 50));
-                }
-                if (key(KEY_DOWN)) {
-                    distance = ((distance + 50) > 1000 ? 1000 : (distance + 50));
-                }
-                if (key(KEY_ESC)) {
-                    break;
-                }
-                handled_key = true;
-            }
-        } else { // no keys down
-            handled_key = false;
-        }
-
-    }
-
-    return 0;
-    
-}
+// Simple rotating 3D cube
+//
+// Original code by Grzegorz Rakoczy
+// fun stuff with coordinates caching and double buffering 
+// added by WojciechGw
+//
+
+#include <rp6502.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "colors.h"
+#include "usb_hid_keys.h"
+#include "bitmap_graphics_db.h"
+#include "pose_cache.h"
+#include "mesh.h"
+#include "scene.h"
+#include "trig.h"
+#include "background.h"
+#include "input.h"
+#include "stats.h"
+#include "governor.h"
+#include "xram_alloc.h"
+#include "xram_io.h"
+#include "asset_stream.h"
+#include "lz.h"
+#include "screen_pack.h"
+
+// #define HIRES
+// #define COLOR    // 4bpp canvas with depth-cued colours
+// #define BITPLANES    // one 2bpp buffer, frames alternate between its bitplanes
+#define NUM_MODES 5
+#define MODE_FILLED 5
+
+// Stress test: start with this many objects ([+]/[-] add and remove them)
+// #define STRESS_INSTANCES 9
+#ifndef STRESS_INSTANCES
+    #define STRESS_INSTANCES 1
+#endif
+
+// Screen related
+//
+#ifdef HIRES
+    #define SCALE 48
+    #define SCREEN_WIDTH 640
+    #define SCREEN_HEIGHT 360
+    #define OFFSET_X 60
+    #define OFFSET_Y 0
+    #define CANVAS_TYPE 4
+    #define BITS_PER_PIXEL 1
+    // the governor's last resort: half the resolution, half the size
+    #define LOW_RES_TYPE 2
+    #define LOW_RES_WIDTH 320
+    #define LOW_RES_HEIGHT 180
+    #define LOW_RES_SHIFT 1
+#elif defined(COLOR)
+    #define SCALE 128
+    #define SCREEN_WIDTH 320
+    #define SCREEN_HEIGHT 180
+    #define OFFSET_X 30
+    #define OFFSET_Y 0
+    #define CANVAS_TYPE 2
+    #define BITS_PER_PIXEL 4
+#elif defined(BITPLANES)
+    #define SCALE 96
+    #define SCREEN_WIDTH 320
+    #define SCREEN_HEIGHT 240
+    #define OFFSET_X 30
+    #define OFFSET_Y 0
+    #define CANVAS_TYPE 1
+    #define BITS_PER_PIXEL 2
+#else
+    #define SCALE 96
+    #define SCREEN_WIDTH 320
+    #define SCREEN_HEIGHT 240
+    #define OFFSET_X 30
+    #define OFFSET_Y 0
+    #define CANVAS_TYPE 1
+    #define BITS_PER_PIXEL 1
+    // the governor's last resort: a quarter fewer rows to clear
+    #define LOW_RES_TYPE 2
+    #define LOW_RES_WIDTH 320
+    #define LOW_RES_HEIGHT 180
+    #define LOW_RES_SHIFT 0
+#endif
+
+#if BITS_PER_PIXEL >= 4
+// Edge colours from the nearest to the farthest
+const uint16_t depth_ramp[] = {WHITE, CYAN, DARK_CYAN, DARK_BLUE};
+#define DEPTH_SHADES (sizeof(depth_ramp) / sizeof(depth_ramp[0]))
+#endif
+
+// Canvas in use, the governor may swap in the low resolution one. Scene
+// coordinates stay in SCREEN_WIDTH x SCREEN_HEIGHT units and are shifted
+// right by screen_shift to draw.
+uint16_t screen_width = SCREEN_WIDTH;
+uint16_t screen_height = SCREEN_HEIGHT;
+uint8_t screen_shift = 0;
+// Canvas pixel the centre of the scene is drawn at
+int16_t origin_x = SCREEN_WIDTH / 2;
+int16_t origin_y = SCREEN_HEIGHT / 2;
+
+// Window mode: a single object is drawn into a canvas just big enough for
+// it, and the video hardware moves that canvas around the screen
+#define WINDOW_MARGIN 12    // room for the vertex labels
+#define BOUNCE_STEP 2       // pixels per pose
+bool window_shown = false;
+int16_t window_x, window_y; // screen position of the canvas
+int8_t bounce_dx = BOUNCE_STEP;
+int8_t bounce_dy = BOUNCE_STEP;
+
+// The simulation advances one pose every TICKS_PER_POSE vsync ticks,
+// however long a frame takes to draw; slow frames skip poses instead of
+// slowing the spin down
+#define TICKS_PER_POSE 4
+// Rotation per pose, in binary angle units (256 per turn)
+#define ANGLE_STEP 2
+// Frame time the governor aims for: a new pose in every frame
+#define TARGET_FRAME_TICKS TICKS_PER_POSE
+
+// for double buffering (or more buffers, when they fit in XRAM)
+#define MAX_BUFFERS 3
+uint16_t buffers[MAX_BUFFERS];
+uint8_t num_buffers = 0;
+uint8_t active_buffer = 0;
+
+#ifdef BITPLANES
+// Every frame is one bitplane of the same buffer. Frame i is shown through
+// palette i, which paints the pixels with bit i set white and ignores the
+// other plane, so only the palette pointer changes to present a frame.
+#define NUM_PLANES BITS_PER_PIXEL
+#define PALETTE_BYTES ((1 << BITS_PER_PIXEL) * 2)
+uint16_t palettes; // in XRAM
+#endif
+int16_t distance = 1000; // for perspective calculations
+
+bool paused = false;
+bool show_indicators = false;
+bool show_vertex_coordinates = false;
+bool interpolate = false;   // draw in-between orientations of the poses
+bool report_stats = false;  // print frame statistics on the console
+bool band_render = false;   // clear and draw each frame in one pass of bands ([R])
+bool governed = true;       // let the governor trade detail for frame rate ([G])
+bool windowed = false;      // bounce a single object around in a small canvas ([W])
+
+// Keyboard related
+//
+// XRAM locations, frame buffers are allocated around them
+#define CANVAS_STRUCT 0xFF00
+#define KEYBOARD_INPUT 0xFF10 // KEYBOARD_BYTES of bitmask data
+
+// Projected cube vertices, cached by orientation
+// (room for a full 256-step cycle of 8-vertex poses)
+#define POSE_CACHE_BYTES 14336
+uint8_t pose_pool[POSE_CACHE_BYTES];
+pose_cache_t pose_cache;
+
+// Cube vertices in 3D space (8 corners of a cube)
+const int16_t cube_vertices[8][3] = {
+    {-4096, -4096, -4096}, {4096, -4096, -4096}, {4096, 4096, -4096}, {-4096, 4096, -4096},  // Back face
+    {-4096, -4096,  4096}, {4096, -4096,  4096}, {4096, 4096,  4096}, {-4096, 4096,  4096}   // Front face
+};
+// Cube edges (back face, front face, connections)
+const uint8_t cube_edges[12][2] = {
+    {0, 1}, {1, 2}, {2, 3}, {3, 0},
+    {4, 5}, {5, 6}, {6, 7}, {7, 4},
+    {0, 4}, {1, 5}, {2, 6}, {3, 7}
+};
+const uint8_t cube_faces[] = {
+    4, 0, 1, 2, 3,   4, 7, 6, 5, 4,   4, 0, 4, 5, 1,
+    4, 1, 5, 6, 2,   4, 2, 6, 7, 3,   4, 3, 7, 4, 0
+};
+const mesh_t cube_mesh = {8, MESH_HAS_FACES, 12, 6, 7094, cube_vertices, cube_edges, cube_faces};
+
+// Additional meshes come from the mesh pack the ROM loads into XRAM
+#define MESH_PACK_XRAM 0xF000
+// A pack built with COMPRESS is loaded LZ-packed where the frame buffers
+// go and unpacked to MESH_PACK_XRAM at startup. rp6502_mesh_pack() then
+// defines MESH_PACK_LZ_XRAM, the XRAM address it was loaded at.
+#define MESH_STORAGE_BYTES 1536
+uint8_t mesh_storage[MESH_STORAGE_BYTES];
+mesh_t loaded_mesh;
+const mesh_t *mesh = &cube_mesh;
+uint8_t mesh_index = 0; // 0 is the built-in cube
+
+// Title and help text baked by tools/bake_screens.py, loaded by the ROM
+// right above two HIRES frame buffers. The images are 1bpp, other canvases
+// draw the text.
+#define SCREEN_PACK_XRAM 0xE100
+#define SCREEN_TITLE 0
+#define SCREEN_HELP 1
+#define SCREEN_HELP_MORE 2
+#define SCREEN_START 3
+#define SCREEN_CONTINUE 4
+
+// Projected vertices of the instance being drawn
+int16_t x2d[MESH_MAX_VERTICES], y2d[MESH_MAX_VERTICES], z2d[MESH_MAX_VERTICES];
+
+// Objects on screen, all instances of the current mesh
+scene_t scene;
+
+// Pose stream played back from the USB drive ([P]), made by
+// tools/bake_poses.py: an 8 byte header, then one projected pose per step
+#define POSE_STREAM_FILE "poses.bin"
+#define POSE_STREAM_HEADER 8
+asset_stream_t pose_stream;
+bool streaming = false;
+int16_t streamed_pose[MESH_MAX_VERTICES * 3]; // also the pose when none fits the cache
+uint32_t streamed_frames = 0;
+
+void WaitForAnyKey(){
+
+    input_event_t event;
+    while (1){
+        // use the wait for pending precomputation
+        background_run();
+        input_poll();
+        while (input_next_event(&event)) {
+            if (event.pressed) {
+                return;
+            }
+        }
+    }
+}
+
+// Recalculate coordinates for perspective view
+//
+/*
+    int16_t addPerspective(int32_t coordinate, int32_t z, int32_t distance){
+    int32_t denominator = distance + z;
+    int32_t scaleFactor = 1000;
+    int32_t scaled_distance = distance * scaleFactor;
+    int32_t ratio = scaled_distance / denominator;
+    return (int16_t)((coordinate * ratio) / scaleFactor);
+}
+*/
+
+#ifdef MESH_PACK_LZ_XRAM
+// Unpack the compressed assets the ROM loaded
+void unpackAssets(void) {
+    uint8_t start = RIA.vsync;
+    uint16_t length = lz_length_xram(MESH_PACK_LZ_XRAM);
+
+    if (length == 0 || length > 0x10000 - MESH_PACK_XRAM) {
+        printf("Mesh pack at $%04X is not LZ data that fits\n", MESH_PACK_LZ_XRAM);
+        return;
+    }
+    lz_unpack_xram(MESH_PACK_LZ_XRAM, MESH_PACK_XRAM);
+    printf("Unpacked mesh pack: %u bytes in %u ticks\n", length, (uint8_t)(RIA.vsync - start));
+}
+#endif
+
+// Lay out XRAM: the fixed regions first, then as many frame buffers as fit
+bool setupXram(void) {
+    uint16_t buffer_bytes = (uint16_t)((uint32_t)SCREEN_WIDTH * SCREEN_HEIGHT * BITS_PER_PIXEL / 8);
+    uint16_t pack_bytes = mesh_pack_bytes(MESH_PACK_XRAM);
+    uint16_t screen_bytes = screen_pack_bytes(SCREEN_PACK_XRAM);
+
+    xram_reset();
+    if (!xram_reserve_at("canvas struct", CANVAS_STRUCT, sizeof(vga_mode3_config_t)) ||
+        !xram_reserve_at("keyboard", KEYBOARD_INPUT, KEYBOARD_BYTES) ||
+        (pack_bytes && !xram_reserve_at("mesh pack", MESH_PACK_XRAM, pack_bytes)) ||
+        (screen_bytes && !xram_reserve_at("screen pack", SCREEN_PACK_XRAM, screen_bytes))) {
+        return false;
+    }
+#ifdef BITPLANES
+    buffers[0] = xram_alloc("frame buffer", buffer_bytes, 1);
+    palettes = xram_alloc("plane palettes", NUM_PLANES * PALETTE_BYTES, 2);
+    if (buffers[0] == XRAM_NONE || palettes == XRAM_NONE) {
+        return false;
+    }
+    for (num_buffers = 0; num_buffers < NUM_PLANES; num_buffers++) {
+        uint16_t palette[1 << BITS_PER_PIXEL];
+        buffers[num_buffers] = buffers[0];
+        for (uint8_t c = 0; c < (1 << BITS_PER_PIXEL); c++) {
+            palette[c] = (c & (1 << num_buffers)) ? color(WHITE, true)
+                                                 : (color_from_rgb5(0, 0, 0) | COLOR_ALPHA_MASK);
+        }
+        // little-endian like the 6502
+        xram_write(palettes + num_buffers * PALETTE_BYTES, palette, PALETTE_BYTES);
+    }
+#else
+    for (num_buffers = 0; num_buffers < MAX_BUFFERS; num_buffers++) {
+        // only the first two buffers are required
+        if (num_buffers >= 2 && xram_largest_free() < buffer_bytes) {
+            break;
+        }
+        buffers[num_buffers] = xram_alloc("frame buffer", buffer_bytes, 1);
+        if (buffers[num_buffers] == XRAM_NONE) {
+            return false;
+        }
+    }
+#endif
+    xram_report();
+    return true;
+}
+
+// Frames are whole buffers, or bitplanes of a single buffer
+void drawToFrame(uint8_t frame) {
+#ifdef BITPLANES
+    set_plane_mask(1 << frame);
+#else
+    (void)frame;
+#endif
+}
+
+void eraseFrame(uint8_t frame) {
+#ifdef BITPLANES
+    erase_planes2buffer(1 << frame, buffers[frame]);
+#else
+    erase_buffer(buffers[frame]);
+#endif
+}
+
+void showFrame(uint8_t frame) {
+#ifdef BITPLANES
+    switch_palette(palettes + frame * PALETTE_BYTES);
+#else
+    switch_buffer(buffers[frame]);
+#endif
+}
+
+// Give the canvas the whole screen, or a window around the object when
+// the window mode applies (one object, not paused: the help needs the
+// whole screen). Frames laid out for the previous size are cleared.
+void applyWindow(void) {
+    uint16_t width = screen_width;
+    uint16_t height = screen_height;
+
+    window_shown = windowed && !paused && scene.count == 1;
+    window_x = 0;
+    window_y = 0;
+    origin_x = screen_width / 2;
+    origin_y = screen_height / 2;
+    if (window_shown) {
+        const scene_instance_t *instance = &scene.instances[0];
+        int16_t cx = origin_x + (instance->x >> screen_shift);
+        int16_t cy = origin_y + (instance->y >> screen_shift);
+        uint16_t side = 2 * ((scene_radius(instance, SCALE) >> screen_shift) + WINDOW_MARGIN);
+
+        side = (side + 7) & ~7; // whole bytes at any depth
+        width = side < screen_width ? side : screen_width;
+        height = side < screen_height ? side : screen_height;
+        // start out where the object is on the whole screen
+        window_x = cx - (int16_t)(width / 2);
+        window_y = cy - (int16_t)(height / 2);
+        if (window_x < 0) {
+            window_x = 0;
+        } else if (window_x > (int16_t)(screen_width - width)) {
+            window_x = screen_width - width;
+        }
+        if (window_y < 0) {
+            window_y = 0;
+        } else if (window_y > (int16_t)(screen_height - height)) {
+            window_y = screen_height - height;
+        }
+        // the object is drawn in the middle of the window
+        origin_x = (int16_t)(width / 2) - (instance->x >> screen_shift);
+        origin_y = (int16_t)(height / 2) - (instance->y >> screen_shift);
+    }
+    canvas_resize(width, height);
+    canvas_move(window_x, window_y);
+    for (uint8_t i = 0; i < num_buffers; i++) {
+        eraseFrame(i);
+    }
+}
+
+// Move the window one step, turning back at the edges of the screen. It
+// shows up with the next frame.
+void bounceWindow(void) {
+    int16_t room_x = screen_width - canvas_width();
+    int16_t room_y = screen_height - canvas_height();
+
+    window_x += bounce_dx;
+    if (window_x <= 0 || window_x >= room_x) {
+        window_x = (window_x <= 0) ? 0 : room_x;
+        bounce_dx = -bounce_dx;
+    }
+    window_y += bounce_dy;
+    if (window_y <= 0 || window_y >= room_y) {
+        window_y = (window_y <= 0) ? 0 : room_y;
+        bounce_dy = -bounce_dy;
+    }
+}
+
+#ifdef LOW_RES_TYPE
+#define MAX_DETAIL_DROP GOVERNOR_LOW_RES
+bool low_res = false;
+
+// Switch between the full and the low resolution canvas, in the same
+// frame buffers. What they hold is laid out for the other one, so every
+// frame is cleared.
+void setLowRes(bool low) {
+    if (low == low_res) {
+        return;
+    }
+    low_res = low;
+    screen_width = low ? LOW_RES_WIDTH : SCREEN_WIDTH;
+    screen_height = low ? LOW_RES_HEIGHT : SCREEN_HEIGHT;
+    screen_shift = low ? LOW_RES_SHIFT : 0;
+    canvas_switch(low ? LOW_RES_TYPE : CANVAS_TYPE, screen_width, screen_height);
+    applyWindow();
+    // the switch is not what the next frame costs
+    governor_reset();
+}
+#else
+// the canvas is as small as it gets already
+#define MAX_DETAIL_DROP GOVERNOR_SIMPLE_MARKERS
+#endif
+
+// Follow the detail level of the governor
+void applyDetail(void) {
+#ifdef LOW_RES_TYPE
+    setLowRes(governor.level >= GOVERNOR_LOW_RES);
+#endif
+}
+
+// Two columns of help, so all keys fit under the title of a 180-row canvas.
+// The second column is 160 pixels right of the first: the same x % 8, so
+// the images baked for x = 10 blit there too.
+#define HELP_ROWS 8
+#define HELP_MORE_X 170
+
+void drawHelpColumn(const char *const *lines, uint8_t count, uint16_t x, uint16_t buffer_data_address) {
+    for (uint8_t i = 0; i < count; i++) {
+        set_cursor(x, screen_height - 20 - HELP_ROWS * 10 + i * 10);
+        draw_string2buffer((char *)lines[i], buffer_data_address);
+    }
+}
+
+// Title, key help and a prompt (SCREEN_START or SCREEN_CONTINUE), blitted
+// from the screen pack when it has them for this canvas. The text here and
+// in tools/bake_screens.py must match.
+void drawHelp(uint8_t prompt, uint16_t buffer_data_address) {
+    static const char *const help[] = {
+        "[SPACE] start/stop",
+        "[M] drawing mode",
+        "[N] next mesh",
+        "[+/-] more/fewer objects",
+        "[UP/DOWN] nearer/farther",
+        "[B] buffer indicator",
+        "[C] vertex coordinates",
+        "[ESC] exit",
+    };
+    static const char *const help_more[] = {
+        "[P] pose stream (USB)",
+        "[I] interpolate poses",
+        "[G] governor, low res",
+        "[W] draw in a window",
+        "[R] band rendering",
+        "[S] stats on console",
+    };
+    uint16_t help_y = screen_height - 20 - HELP_ROWS * 10;
+
+    if (!screen_pack_blit(SCREEN_PACK_XRAM, SCREEN_TITLE, 10, 10, buffer_data_address)) {
+        set_text_multiplier(4);
+        set_cursor(10, 10);
+        draw_string2buffer("3D cube", buffer_data_address);
+        set_text_multiplier(1);
+    }
+    if (!screen_pack_blit(SCREEN_PACK_XRAM, SCREEN_HELP, 10, help_y, buffer_data_address)) {
+        drawHelpColumn(help, sizeof(help) / sizeof(help[0]), 10, buffer_data_address);
+    }
+    if (!screen_pack_blit(SCREEN_PACK_XRAM, SCREEN_HELP_MORE, HELP_MORE_X, help_y, buffer_data_address)) {
+        drawHelpColumn(help_more, sizeof(help_more) / sizeof(help_more[0]), HELP_MORE_X, buffer_data_address);
+    }
+    if (!screen_pack_blit(SCREEN_PACK_XRAM, prompt, 10, screen_height - 10, buffer_data_address)) {
+        set_cursor(10, screen_height - 10);
+        draw_string2buffer(prompt == SCREEN_START ? "PRESS ANY KEY TO START" : "Press SPACE to continue",
+                           buffer_data_address);
+    }
+    canvas_flush();
+}
+
+// Take the next pose of the stream, starting over at its end
+void nextStreamPose(void) {
+    uint16_t bytes = (uint16_t)mesh->vertex_count * 3 * sizeof(int16_t);
+
+    if (asset_stream_read(&pose_stream, streamed_pose, bytes) < bytes) {
+        asset_stream_seek(&pose_stream, POSE_STREAM_HEADER);
+        asset_stream_read(&pose_stream, streamed_pose, bytes);
+    }
+}
+
+void stopStream(void) {
+    if (streaming) {
+        streaming = false;
+        asset_stream_close(&pose_stream);
+        printf("Pose stream: %lu bytes in %lu frames, %u stalls\n",
+               pose_stream.bytes_read, streamed_frames, pose_stream.stalls);
+    }
+}
+
+// Play the pose stream if it was made for the current mesh and screen mode
+bool startStream(void) {
+    uint8_t header[POSE_STREAM_HEADER];
+
+    if (!asset_stream_open(&pose_stream, POSE_STREAM_FILE)) {
+        printf("Can not open %s\n", POSE_STREAM_FILE);
+        return false;
+    }
+    if (asset_stream_read(&pose_stream, header, sizeof(header)) < sizeof(header) ||
+        header[0] != 'P' || header[1] != 'S' || header[2] != mesh->vertex_count ||
+        (header[6] | (header[7] << 8)) != SCALE) {
+        printf("%s is not a pose stream for this mesh and screen\n", POSE_STREAM_FILE);
+        asset_stream_close(&pose_stream);
+        return false;
+    }
+    streaming = true;
+    streamed_frames = 0;
+    nextStreamPose();
+    return true;
+}
+
+// Select mesh number index (0 is the cube, then the mesh pack entries)
+void selectMesh(uint8_t index) {
+    if (index > mesh_pack_count(MESH_PACK_XRAM)) {
+        index = 0;
+    }
+    // the pose stream is only good for the mesh it was made for
+    stopStream();
+    mesh_index = index;
+    mesh = &cube_mesh;
+    if (index > 0) {
+        if (mesh_load_xram(&loaded_mesh, mesh_pack_entry(MESH_PACK_XRAM, index - 1),
+                           mesh_storage, sizeof(mesh_storage))) {
+            mesh = &loaded_mesh;
+        } else {
+            printf("Mesh %u does not fit, using the cube\n", index);
+            mesh_index = 0;
+        }
+    }
+    for (uint8_t i = 0; i < scene.count; i++) {
+        scene.instances[i].mesh = mesh;
+    }
+    // poses of the previous mesh are useless now
+    if (!pose_cache_init(&pose_cache, pose_pool, sizeof(pose_pool), mesh->vertex_count)) {
+        printf("No room to cache poses of mesh %u\n", mesh_index);
+    }
+}
+
+// Place count instances of the current mesh on a grid
+void layoutScene(uint8_t count) {
+    uint8_t cols = 1;
+
+    if (count < 1) {
+        count = 1;
+    }
+    if (count > SCENE_MAX_INSTANCES) {
+        count = SCENE_MAX_INSTANCES;
+    }
+    while (cols * cols < count) {
+        cols++;
+    }
+
+    scene.count = 0;
+    if (count == 1) {
+        scene_add(&scene, mesh, OFFSET_X, OFFSET_Y, 0, 0, SCENE_SCALE_ONE);
+        return;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t row = i / cols;
+        uint8_t col = i % cols;
+        // slightly oversized so that neighbours overlap, rows further down are nearer
+        scene_add(&scene, mesh,
+                  (int16_t)((2 * col + 1 - cols) * (SCREEN_WIDTH / 2 / cols)),
+                  (int16_t)((2 * row + 1 - cols) * (SCREEN_HEIGHT / 2 / cols)),
+                  (int16_t)(cols - row) * 16,
+                  i * 23, SCENE_SCALE_ONE * 3 / (2 * cols));
+    }
+}
+
+// Rotate and project the mesh vertices for one orientation
+// (relative to the centre of the screen)
+static void projectMesh(angle_t angleX, angle_t angleY, angle_t angleZ, int16_t *projected) {
+
+    long sinX = isin(angleX), cosX = icos(angleX);
+    long sinY = isin(angleY), cosY = icos(angleY);
+    long sinZ = isin(angleZ), cosZ = icos(angleZ);
+
+    for (uint8_t i = 0; i < mesh->vertex_count; i++) {
+
+        int16_t x = mesh->vertices[i][0];
+        int16_t y = mesh->vertices[i][1];
+        int16_t z = mesh->vertices[i][2];
+
+        // rotate y
+        int16_t rotx = ((long)x * cosY + (long)z * sinY)>> 12;
+        int16_t roty = (long)y;
+        int16_t rotz = ((long)z * cosY - (long)x * sinY)>> 12;
+        // rotate x
+        int16_t rotxx = (long)rotx;
+        int16_t rotyy = ((long)roty * cosX - (long)rotz * sinX)>> 12;
+        int16_t rotzz = ((long)roty * sinX + (long)rotz * cosX)>> 12;
+        // rotate z
+        int16_t rotxxx = ((long)rotxx * cosZ - (long)rotyy * sinZ)>> 12;
+        int16_t rotyyy = ((long)rotxx * sinZ + (long)rotyy * cosZ)>> 12;
+        int16_t rotzzz = (long)rotzz;
+
+        // add perspective
+        int16_t rotxxx_p = rotxxx; // addPerspective((int32_t)rotxxx, (int32_t)rotzzz, (int32_t)distance);
+        int16_t rotyyy_p = rotyyy; // addPerspective((int32_t)rotyyy, (int32_t)rotzzz, (int32_t)distance);
+
+        *projected++ = rotxxx_p / SCALE;
+        *projected++ = rotyyy_p / SCALE;
+        *projected++ = rotzzz / SCALE;
+    }
+}
+
+// Project the (quantized) orientation a pose cache key stands for
+static void projectPose(angle_t angleX, angle_t angleY, angle_t angleZ, int16_t *projected) {
+    projectMesh(angleX >> POSE_ANGLE_SHIFT << POSE_ANGLE_SHIFT,
+                angleY >> POSE_ANGLE_SHIFT << POSE_ANGLE_SHIFT,
+                angleZ >> POSE_ANGLE_SHIFT << POSE_ANGLE_SHIFT, projected);
+}
+
+// Background job: precompute the orientations the spin will reach next,
+// one pose per slice, until a full turn is cached or the cache is full
+angle_t warm_angleX, warm_angleY, warm_angleZ;
+uint8_t warm_stride = ANGLE_STEP;
+uint16_t warm_steps = 0;
+
+bool warmPoses(void) {
+    int16_t *projected;
+
+    if (warm_steps >= 256 / warm_stride || pose_cache.used >= pose_cache.capacity) {
+        return true;
+    }
+    if (!pose_cache_warm(&pose_cache, pose_key(warm_angleX, warm_angleY, warm_angleZ), &projected)) {
+        projectPose(warm_angleX, warm_angleY, warm_angleZ, projected);
+    }
+    warm_angleX += warm_stride;
+    warm_angleY += warm_stride;
+    warm_angleZ += warm_stride;
+    warm_steps++;
+    return false;
+}
+
+// (Re)start warming the pose cache from the given orientation
+void warmPosesFrom(angle_t angleX, angle_t angleY, angle_t angleZ) {
+    warm_angleX = angleX;
+    warm_angleY = angleY;
+    warm_angleZ = angleZ;
+    // interpolated frames also show the orientations in between poses
+    warm_stride = interpolate ? 1 : ANGLE_STEP;
+    warm_steps = 0;
+    background_add(warmPoses);
+}
+
+// Draw one mesh instance by connecting the vertices with lines
+void drawMesh(const scene_instance_t *instance, angle_t angleX, angle_t angleY, angle_t angleZ, int16_t color, uint8_t mode, uint16_t buffer_data_address) {
+
+    const mesh_t *m = instance->mesh;
+    int16_t *projected;
+    uint8_t count = m->vertex_count;
+    int16_t cx = origin_x + (instance->x >> screen_shift);
+    int16_t cy = origin_y + (instance->y >> screen_shift);
+
+    // Reuse the projection of an orientation seen before
+    if (streaming) {
+        projected = streamed_pose;
+    } else if (!pose_cache_fetch(&pose_cache, pose_key(angleX, angleY, angleZ), &projected)) {
+        if (!projected) {
+            projected = streamed_pose; // no cache: project every frame
+        }
+        projectPose(angleX, angleY, angleZ, projected);
+    }
+
+    // scale and send to the instance position (depth stays in scene units)
+    if (instance->scale == SCENE_SCALE_ONE) {
+        for (uint8_t i = 0; i < count; i++) {
+            x2d[i] = (*projected++ >> screen_shift) + cx;
+            y2d[i] = (*projected++ >> screen_shift) + cy;
+            z2d[i] = *projected++;
+        }
+    } else {
+        long one = (long)SCENE_SCALE_ONE << screen_shift;
+        for (uint8_t i = 0; i < count; i++) {
+            x2d[i] = (int16_t)(((long)*projected++ * instance->scale) / one) + cx;
+            y2d[i] = (int16_t)(((long)*projected++ * instance->scale) / one) + cy;
+            z2d[i] = (int16_t)(((long)*projected++ * instance->scale) / SCENE_SCALE_ONE);
+        }
+    }
+
+    // Faces filled back to front hide what is behind them
+    if (mode == MODE_FILLED) {
+        if (m->flags & MESH_HAS_FACES) {
+#if BITS_PER_PIXEL >= 4
+            mesh_draw_faces(m, x2d, y2d, z2d, DARK_BLUE, color, buffer_data_address);
+#else
+            mesh_draw_faces(m, x2d, y2d, z2d, BLACK, color, buffer_data_address);
+#endif
+        } else {
+            mesh_draw_edges(m, x2d, y2d, color, buffer_data_address);
+        }
+        return;
+    }
+
+    // Connect the vertices with lines to draw the mesh
+    if (mode == 0 || mode > 3) {
+#if BITS_PER_PIXEL >= 4
+        mesh_draw_edges_shaded(m, x2d, y2d, z2d, scene_radius(instance, SCALE),
+                               depth_ramp, DEPTH_SHADES, buffer_data_address);
+#else
+        mesh_draw_edges(m, x2d, y2d, color, buffer_data_address);
+#endif
+        // additional cross to indicate front side of the cube
+        if(mode == 4 && m == &cube_mesh){
+            draw_line2buffer(color, x2d[2], y2d[2], x2d[7], y2d[7], buffer_data_address);
+            draw_line2buffer(color, x2d[3], y2d[3], x2d[6], y2d[6], buffer_data_address);
+        }
+    }
+
+    if (mode == 1) {
+        for(uint8_t v = 0; v < count; v++){
+            draw_pixel2buffer(color, x2d[v], y2d[v], buffer_data_address);
+        }
+    }
+
+    if (mode > 1){
+        for(uint8_t v = 0; v < count; v++){
+            if (governor.level >= GOVERNOR_SIMPLE_MARKERS) {
+                draw_pixel2buffer(color, x2d[v] + 3, y2d[v] + 3, buffer_data_address);
+                continue;
+            }
+            // if(z2d[v] <= 0) draw_circle2buffer(color, x2d[v], y2d[v], 3, buffer_data_address);
+            set_cursor(x2d[v] + 3, y2d[v] + 3);
+            if (governor.level < GOVERNOR_PLAIN_TEXT) {
+                set_text_multiplier((z2d[v] < 0) ? ((z2d[v] < -90) ? 3 : 2) : 1);
+            }
+            draw_int2buffer(v, buffer_data_address);
+            set_text_multiplier(1);
+        }
+    }
+}
+
+// Overlay text: label, then value in decimal, without sprintf
+void drawField(const char *label, uint32_t value, uint16_t buffer_data_address) {
+    char str[FORMAT_ULONG_BYTES];
+
+    draw_string2buffer((char *)label, buffer_data_address);
+    format_ulong(str, value);
+    draw_string2buffer(str, buffer_data_address);
+}
+
+// Draw every visible instance, farthest first
+void drawScene(angle_t angleX, angle_t angleY, angle_t angleZ, int16_t color, uint8_t mode, uint16_t buffer_data_address) {
+
+    // cull before anything gets transformed
+    scene_cull_and_sort(&scene, SCALE, screen_width << screen_shift, screen_height << screen_shift);
+
+    for (uint8_t i = 0; i < scene.visible; i++) {
+        const scene_instance_t *instance = &scene.instances[scene.order[i]];
+        drawMesh(instance,
+                 angleX + instance->phase,
+                 angleY + instance->phase,
+                 angleZ + instance->phase,
+                 color, mode, buffer_data_address);
+    }
+
+    // show additional infos (coordinates of the nearest instance)
+    if (show_vertex_coordinates && governor.level < GOVERNOR_PLAIN_TEXT){
+        for (uint8_t i = 0; i < mesh->vertex_count && i < 8; i++) {
+            set_cursor(20, 40 + i * 10);
+            // "i (x,y,z)", without sprintf in the per vertex loop
+            draw_int2buffer(i, buffer_data_address);
+            draw_string2buffer(" (", buffer_data_address);
+            draw_int2buffer(x2d[i], buffer_data_address);
+            draw_string2buffer(",", buffer_data_address);
+            draw_int2buffer(y2d[i], buffer_data_address);
+            draw_string2buffer(",", buffer_data_address);
+            draw_int2buffer(z2d[i], buffer_data_address);
+            draw_string2buffer(")", buffer_data_address);
+        }
+        const pixel_cache_stats_t *pixels = pixel_cache_stats();
+        set_cursor(20, 120);
+        drawField("pixels: ", pixels->pixels, buffer_data_address);
+        drawField(", ", pixels->merged, buffer_data_address);
+        drawField(" merged, ", pixels->written, buffer_data_address);
+        draw_string2buffer(" written", buffer_data_address);
+        set_cursor(20, 130);
+        if (streaming) {
+            drawField("stream: ", streamed_frames ? pose_stream.bytes_read / streamed_frames : 0,
+                      buffer_data_address);
+            drawField(" bytes/frame, ", pose_stream.stalls, buffer_data_address);
+            draw_string2buffer(" stalls", buffer_data_address);
+        } else {
+            drawField("pose cache: ", pose_cache.hits, buffer_data_address);
+            drawField(" hits, ", pose_cache.misses, buffer_data_address);
+            draw_string2buffer(" misses", buffer_data_address);
+        }
+        set_cursor(20, 140);
+        drawField("mesh ", mesh_index, buffer_data_address);
+        drawField(": ", mesh->vertex_count, buffer_data_address);
+        drawField(" vertices, ", mesh->edge_count, buffer_data_address);
+        draw_string2buffer(" edges", buffer_data_address);
+        set_cursor(20, 150);
+        drawField("objects: ", scene.visible, buffer_data_address);
+        drawField(" of ", scene.count, buffer_data_address);
+        draw_string2buffer(" visible", buffer_data_address);
+        set_cursor(20, 160);
+        drawField("", stats_fps(), buffer_data_address);
+        drawField(" fps, ", stats_pps(), buffer_data_address);
+        draw_string2buffer(interpolate ? " poses/s, interpolated" : " poses/s", buffer_data_address);
+        set_cursor(20, 170);
+        drawField("erase: ", stats.erase_ticks, buffer_data_address);
+        drawField(" of ", stats.ticks, buffer_data_address);
+        draw_string2buffer(" ticks", buffer_data_address);
+        if (band_render) {
+            const band_stats_t *bands = band_render_stats();
+            set_cursor(20, 180);
+            drawField("bands: ", bands->frames ? bands->items / bands->frames : 0, buffer_data_address);
+            drawField(" items/frame, ", bands->overflows, buffer_data_address);
+            draw_string2buffer(" overflows", buffer_data_address);
+        }
+    }
+}
+
+int main() {
+    uint8_t startup_vsync = RIA.vsync;
+
+#ifdef MESH_PACK_LZ_XRAM
+    unpackAssets();
+#endif
+    input_init(KEYBOARD_INPUT);
+    selectMesh(0);
+    layoutScene(STRESS_INSTANCES);
+
+    uint8_t mode = 0;
+    uint8_t i = 0;
+    if (!setupXram()) {
+        printf("XRAM layout does not fit\n");
+        return 1;
+    }
+
+    init_bitmap_graphics(CANVAS_STRUCT, buffers[0], 0, CANVAS_TYPE, SCREEN_WIDTH, SCREEN_HEIGHT, BITS_PER_PIXEL);
+    for (i = 0; i < num_buffers; i++) {
+        eraseFrame(i);
+    }
+
+    // force 1st buffer
+    active_buffer = 0;
+    showFrame(active_buffer);
+    drawToFrame(active_buffer);
+
+    // start angles
+    angle_t start_angleX = 28, start_angleY = 28, start_angleZ = 14;
+    drawScene(start_angleX, start_angleY, start_angleZ, WHITE, mode, buffers[active_buffer]);
+    angle_t angleX = start_angleX;
+    angle_t angleY = start_angleY;
+    angle_t angleZ = start_angleZ;
+
+    drawHelp(SCREEN_START, buffers[active_buffer]);
+    // the first turn gets precomputed while the title is shown
+    warmPosesFrom(start_angleX + ANGLE_STEP, start_angleY + ANGLE_STEP, start_angleZ + ANGLE_STEP);
+    printf("Startup: %u ticks\n", (uint8_t)(RIA.vsync - startup_vsync));
+    WaitForAnyKey();
+
+    input_event_t event;
+    bool running = true;
+    uint8_t last_vsync = RIA.vsync;
+    uint16_t pose_ticks = 0; // ticks since the current pose
+    stats_reset(mode);
+    governor_init(TARGET_FRAME_TICKS, MAX_DETAIL_DROP);
+    while (running) {
+
+        if(!paused){
+            // Advance the simulation by the ticks that have passed
+            uint8_t vsync = RIA.vsync;
+            uint8_t poses = 0;
+            pose_ticks += (uint8_t)(vsync - last_vsync);
+            last_vsync = vsync;
+            while (pose_ticks >= TICKS_PER_POSE) {
+                angleX += ANGLE_STEP;
+                angleY += ANGLE_STEP;
+                angleZ += ANGLE_STEP;
+                pose_ticks -= TICKS_PER_POSE;
+                poses++;
+                if (window_shown) {
+                    bounceWindow();
+                }
+                if (streaming) {
+                    nextStreamPose();
+                }
+            }
+            stats_poses_simulated(poses);
+
+            // Show the latest state, or where it is heading by now
+            angle_t delta = interpolate ? (angle_t)(ANGLE_STEP * pose_ticks / TICKS_PER_POSE) : 0;
+
+            // screen double buffering magic
+            // draw on the buffer that was shown longest ago
+            uint8_t next_buffer = (active_buffer + 1 == num_buffers) ? 0 : active_buffer + 1;
+            uint8_t erase_start = RIA.vsync;
+            drawToFrame(next_buffer);
+            // banded frames are cleared while they are drawn, in canvas_record_end
+            bool banded = band_render && canvas_record_begin(buffers[next_buffer]);
+            if (!banded) {
+                eraseFrame(next_buffer);
+            }
+            stats_erase_ticks(RIA.vsync - erase_start);
+            drawScene(angleX + delta, angleY + delta, angleZ + delta, WHITE, mode, buffers[next_buffer]);
+
+            if(show_indicators){
+                // spread over the canvas, all at the left of a window narrower than that
+                int16_t room = (int16_t)canvas_width() - 40;
+                int16_t indicator_x = 20;
+                if (room > 0 && num_buffers > 1) {
+                    indicator_x += next_buffer * (room / (num_buffers - 1));
+                }
+                draw_circle2buffer(WHITE, indicator_x, 20, 8, buffers[next_buffer]);
+                if (governor.level < GOVERNOR_SIMPLE_MARKERS) {
+                    set_cursor(indicator_x - 2, 17);
+                    draw_int2buffer(next_buffer, buffers[next_buffer]);
+                }
+            }
+            if (banded) {
+                canvas_record_end();
+            }
+           
+            // switch to updated buffer
+            showFrame(next_buffer);
+            if (window_shown) {
+                canvas_move(window_x, window_y);
+            }
+            // switch active buffer index for next loop
+            active_buffer = next_buffer;
+
+            stats_frame_rendered();
+            stats_update(mode);
+            if (governed && governor_frame_rendered()) {
+                stats_governor(governor.level, governor.window_ticks);
+                applyDetail();
+            }
+
+            // load what the next frame will read
+            if (streaming) {
+                streamed_frames++;
+                asset_stream_prefetch(&pose_stream);
+            }
+        } else {
+            // idle, precompute what comes after the pause
+            background_run();
+            // time stands still while paused
+            last_vsync = RIA.vsync;
+            stats_reset(mode);
+            governor_reset();
+        }
+
+        // handle the keystrokes, once per keypress
+        input_poll();
+        while (input_next_event(&event)) {
+            if (!event.pressed) {
+                continue;
+            }
+            switch (event.code) {
+                case KEY_SPACE:
+                    paused = !paused;
+                    if(paused){
+                        warmPosesFrom(angleX + ANGLE_STEP, angleY + ANGLE_STEP, angleZ + ANGLE_STEP);
+                        drawToFrame(active_buffer);
+                        if (window_shown) {
+                            // back to the whole screen for the help
+                            applyWindow();
+                            drawScene(angleX, angleY, angleZ, WHITE, mode, buffers[active_buffer]);
+                        }
+                        drawHelp(SCREEN_CONTINUE, buffers[active_buffer]);
+                    } else if (windowed) {
+                        applyWindow();
+                    }
+                    break;
+                case KEY_B:
+                    show_indicators = !show_indicators;
+                    break;
+                case KEY_M:
+                    mode = ((mode + 1) > NUM_MODES ? 0 : (mode + 1));
+                    break;
+                case KEY_N:
+                    selectMesh(mesh_index + 1);
+                    if (windowed) {
+                        applyWindow(); // sized for the new mesh
+                    }
+                    warmPosesFrom(angleX + ANGLE_STEP, angleY + ANGLE_STEP, angleZ + ANGLE_STEP);
+                    break;
+                case KEY_EQUAL:
+                case KEY_KPPLUS:
+                    layoutScene(scene.count + 1);
+                    if (windowed) {
+                        applyWindow();
+                    }
+                    break;
+                case KEY_MINUS:
+                case KEY_KPMINUS:
+                    layoutScene(scene.count - 1);
+                    if (windowed) {
+                        applyWindow();
+                    }
+                    break;
+                case KEY_C:
+                    show_vertex_coordinates = !show_vertex_coordinates;
+                    break;
+                case KEY_P:
+                    if (streaming) {
+                        stopStream();
+                    } else {
+                        startStream();
+                    }
+                    break;
+                case KEY_I:
+                    interpolate = !interpolate;
+                    warmPosesFrom(angleX + ANGLE_STEP, angleY + ANGLE_STEP, angleZ + ANGLE_STEP);
+                    break;
+                case KEY_G:
+                    governed = !governed;
+                    if (!governed) {
+                        governor_restore();
+                        applyDetail();
+                    } else {
+                        governor_reset();
+                    }
+                    stats_governor_manual(governor.level);
+                    break;
+                case KEY_W:
+                    windowed = !windowed;
+                    applyWindow();
+                    break;
+                case KEY_R:
+                    band_render = !band_render;
+                    break;
+                case KEY_S:
+                    report_stats = !report_stats;
+                    stats_set_report(report_stats);
+                    break;
+                case KEY_UP:
+                    distance = ((distance - 50) < 100 ? 100 : (distance - 50));
+                    break;
+                case KEY_DOWN:
+                    distance = ((distance + 50) > 1000 ? 1000 : (distance + 50));
+                    break;
+                case KEY_ESC:
+                    running = false;
+                    break;
+            }
+        }
+
+    }
+
+    return 0;
+    
+}
@@ -0,0 +1,226 @@
+// ---------------------------------------------------------------------------
+// mesh.c
+//
+// Wireframe meshes loaded from XRAM and drawn by walking their edge list.
+// ---------------------------------------------------------------------------
+
+#include <rp6502.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "bitmap_graphics_db.h"
+#include "mesh.h"
+#include "xram_io.h"
+
+// ---------------------------------------------------------------------------
+// Little-endian reads through port 0 (step0 must be 1)
+// ---------------------------------------------------------------------------
+static uint16_t read_word(void)
+{
+    uint16_t lo = RIA.rw0;
+    return lo | ((uint16_t)RIA.rw0 << 8);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint8_t mesh_pack_count(uint16_t xram_addr)
+{
+    RIA.addr0 = xram_addr;
+    RIA.step0 = 1;
+    if (RIA.rw0 != 'M' || RIA.rw0 != 'P') {
+        return 0;
+    }
+    return RIA.rw0;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint16_t mesh_pack_entry(uint16_t xram_addr, uint8_t index)
+{
+    RIA.addr0 = xram_addr + 4 + 2 * index;
+    RIA.step0 = 1;
+    return xram_addr + read_word();
+}
+
+// ---------------------------------------------------------------------------
+// The pack ends with its last mesh
+// ---------------------------------------------------------------------------
+uint16_t mesh_pack_bytes(uint16_t xram_addr)
+{
+    uint8_t count = mesh_pack_count(xram_addr);
+    uint16_t last, edge_count, face_bytes;
+    uint8_t vertex_count;
+
+    if (count == 0) {
+        return 0;
+    }
+    last = mesh_pack_entry(xram_addr, count - 1);
+    RIA.addr0 = last + 2;
+    RIA.step0 = 1;
+    vertex_count = RIA.rw0;
+    (void)RIA.rw0;  // flags
+    edge_count = read_word();
+    read_word();    // face_count
+    face_bytes = read_word();
+
+    return last - xram_addr + MESH_HEADER_BYTES +
+           (uint16_t)vertex_count * 3 * sizeof(int16_t) + edge_count * 2 + face_bytes;
+}
+
+// ---------------------------------------------------------------------------
+// The drawing code indexes the projected vertex arrays with these as they
+// are, so every edge and face index must name a vertex, and the face
+// records (n >= 3, then n indices) must stay within face_bytes
+// ---------------------------------------------------------------------------
+static bool indices_valid(const mesh_t *mesh, uint16_t face_bytes)
+{
+    const uint8_t *p = (const uint8_t *)mesh->edges;
+    uint16_t i, left;
+    uint8_t j, n;
+
+    for (i = 0; i < mesh->edge_count; i++, p += 2) {
+        if (p[0] >= mesh->vertex_count || p[1] >= mesh->vertex_count) {
+            return false;
+        }
+    }
+    p = mesh->faces;
+    left = face_bytes;
+    for (i = 0; i < mesh->face_count; i++) {
+        if (left == 0) {
+            return false;
+        }
+        n = p[0];
+        if (n < 3 || n >= left) {
+            return false;
+        }
+        for (j = 1; j <= n; j++) {
+            if (p[j] >= mesh->vertex_count) {
+                return false;
+            }
+        }
+        p += n + 1;
+        left -= n + 1;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// The size is summed in 32 bits, so a large edge count or face_bytes can
+// not wrap past the storage check
+// ---------------------------------------------------------------------------
+bool mesh_load_xram(mesh_t *mesh, uint16_t xram_addr, uint8_t *storage, uint16_t storage_bytes)
+{
+    uint16_t face_bytes, vertex_bytes, edge_bytes;
+
+    RIA.addr0 = xram_addr;
+    RIA.step0 = 1;
+    if (RIA.rw0 != 'M' || RIA.rw0 != '3') {
+        return false;
+    }
+    mesh->vertex_count = RIA.rw0;
+    mesh->flags = RIA.rw0;
+    mesh->edge_count = read_word();
+    mesh->face_count = read_word();
+    face_bytes = read_word();
+    mesh->radius = read_word();
+
+    if (mesh->vertex_count > MESH_MAX_VERTICES ||
+        (uint32_t)mesh->vertex_count * 3 * sizeof(int16_t) + (uint32_t)mesh->edge_count * 2 +
+        face_bytes > storage_bytes) {
+        return false;
+    }
+    vertex_bytes = (uint16_t)mesh->vertex_count * 3 * sizeof(int16_t);
+    edge_bytes = mesh->edge_count * 2;
+
+    // vertices, edges and faces follow the header back to back
+    xram_read(storage, xram_addr + MESH_HEADER_BYTES, vertex_bytes + edge_bytes + face_bytes);
+    mesh->vertices = (const int16_t (*)[3])storage;
+    mesh->edges = (const uint8_t (*)[2])(storage + vertex_bytes);
+    mesh->faces = storage + vertex_bytes + edge_bytes;
+
+    return indices_valid(mesh, face_bytes);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void mesh_draw_edges(const mesh_t *mesh, const int16_t *x2d, const int16_t *y2d,
+                     uint16_t color, uint16_t buffer_data_address)
+{
+    const uint8_t (*edge)[2] = mesh->edges;
+    uint16_t i;
+
+    for (i = 0; i < mesh->edge_count; i++, edge++) {
+        uint8_t a = (*edge)[0];
+        uint8_t b = (*edge)[1];
+        draw_line2buffer(color, x2d[a], y2d[a], x2d[b], y2d[b], buffer_data_address);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void mesh_draw_edges_shaded(const mesh_t *mesh, const int16_t *x2d, const int16_t *y2d, const int16_t *z2d,
+                            int16_t radius, const uint16_t *ramp, uint8_t shades,
+                            uint16_t buffer_data_address)
+{
+    const uint8_t (*edge)[2] = mesh->edges;
+    // the depth of an edge is the sum of its end points, -2r..2r
+    int16_t band = (4 * radius) / shades + 1;
+    uint16_t i;
+
+    for (i = 0; i < mesh->edge_count; i++, edge++) {
+        uint8_t a = (*edge)[0];
+        uint8_t b = (*edge)[1];
+        int16_t depth = z2d[a] + z2d[b] + 2 * radius;
+        uint8_t shade = (depth <= 0) ? 0 : depth / band;
+        if (shade >= shades) {
+            shade = shades - 1;
+        }
+        draw_line2buffer(ramp[shade], x2d[a], y2d[a], x2d[b], y2d[b], buffer_data_address);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void mesh_draw_faces(const mesh_t *mesh, const int16_t *x2d, const int16_t *y2d, const int16_t *z2d,
+                     uint16_t fill_color, uint16_t edge_color, uint16_t buffer_data_address)
+{
+    static const uint8_t *face[MESH_MAX_FACES];
+    static int16_t depth[MESH_MAX_FACES];
+    const uint8_t *f = mesh->faces;
+    uint8_t count = 0;
+    uint8_t i, j, n;
+
+    // depth of a face is the sum of its vertex depths, farthest first
+    while (count < mesh->face_count && count < MESH_MAX_FACES) {
+        int16_t d = 0;
+        n = f[0];
+        for (i = 1; i <= n; i++) {
+            d += z2d[f[i]];
+        }
+        j = count++;
+        while (j > 0 && depth[j - 1] < d) {
+            face[j] = face[j - 1];
+            depth[j] = depth[j - 1];
+            j--;
+        }
+        face[j] = f;
+        depth[j] = d;
+        f += n + 1;
+    }
+
+    for (j = 0; j < count; j++) {
+        uint8_t a;
+        f = face[j];
+        n = f[0];
+        a = f[1];
+        for (i = 2; i < n; i++) {
+            uint8_t b = f[i];
+            uint8_t c = f[i + 1];
+            fill_triangle2buffer(fill_color, x2d[a], y2d[a], x2d[b], y2d[b], x2d[c], y2d[c], buffer_data_address);
+        }
+        for (i = 1; i <= n; i++) {
+            uint8_t b = f[i];
+            uint8_t c = f[(i < n) ? i + 1 : 1];
+            draw_line2buffer(edge_color, x2d[b], y2d[b], x2d[c], y2d[c], buffer_data_address);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+// ---------------------------------------------------------------------------
+// mesh.h
+//
+// Wireframe meshes: a shared vertex array, a deduplicated edge index list
+// and optional faces. Every vertex is transformed once per pose and the
+// renderer just walks the edge list.
+//
+// Meshes other than the built-in ones are converted on the host from
+// Wavefront OBJ files by tools/obj2mesh.py and loaded into XRAM by the ROM.
+// Binary layout (little-endian):
+//
+//   mesh pack:  'M' 'P' count 0  uint16 offset[count]   (from pack start)
+//   mesh:       'M' '3' vertex_count flags
+//               uint16 edge_count  uint16 face_count  uint16 face_bytes
+//               uint16 radius
+//               int16  vertices[vertex_count][3]
+//               uint8  edges[edge_count][2]
+//               uint8  faces[face_bytes]   (n, then n vertex indices)
+// ---------------------------------------------------------------------------
+
+#ifndef MESH_H
+#define MESH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MESH_MAX_VERTICES 128
+#define MESH_MAX_FACES 128
+#define MESH_HEADER_BYTES 12
+
+#define MESH_HAS_FACES 0x01
+
+typedef struct {
+    uint8_t  vertex_count;
+    uint8_t  flags;
+    uint16_t edge_count;
+    uint16_t face_count;
+    uint16_t radius;             // bounding sphere, in vertex units
+    const int16_t (*vertices)[3];
+    const uint8_t (*edges)[2];
+    const uint8_t *faces;        // face_count records of n, then n indices
+} mesh_t;
+
+// Number of meshes in the pack at xram_addr, 0 if there is no pack
+uint8_t mesh_pack_count(uint16_t xram_addr);
+// XRAM address of mesh number index in the pack
+uint16_t mesh_pack_entry(uint16_t xram_addr, uint8_t index);
+// Bytes of XRAM taken by the pack at xram_addr, 0 if there is no pack
+uint16_t mesh_pack_bytes(uint16_t xram_addr);
+// Copy the mesh at xram_addr into storage and point mesh at it.
+// Returns false if it is not a mesh, does not fit or has an edge or face
+// index that names no vertex.
+bool mesh_load_xram(mesh_t *mesh, uint16_t xram_addr, uint8_t *storage, uint16_t storage_bytes);
+
+// Draw every edge between projected screen points
+void mesh_draw_edges(const mesh_t *mesh, const int16_t *x2d, const int16_t *y2d,
+                     uint16_t color, uint16_t buffer_data_address);
+// Draw every edge in a colour picked by its depth: ramp holds shades
+// colours from nearest to farthest, radius bounds the depth values
+void mesh_draw_edges_shaded(const mesh_t *mesh, const int16_t *x2d, const int16_t *y2d, const int16_t *z2d,
+                            int16_t radius, const uint16_t *ramp, uint8_t shades,
+                            uint16_t buffer_data_address);
+// Draw the faces back to front (painter's algorithm), each one filled with
+// fill_color and outlined with edge_color. Faces are filled as triangle
+// fans, so they are expected to be convex.
+void mesh_draw_faces(const mesh_t *mesh, const int16_t *x2d, const int16_t *y2d, const int16_t *z2d,
+                     uint16_t fill_color, uint16_t edge_color, uint16_t buffer_data_address);
+
+#endif // MESH_H
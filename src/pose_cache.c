@@ -0,0 +1,137 @@
+// ---------------------------------------------------------------------------
+// pose_cache.c
+//
+// Bounded cache of projected vertex sets keyed by quantized orientation.
+// ---------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "pose_cache.h"
+
+// ---------------------------------------------------------------------------
+// Fold the three angle fields of a key into a bucket index
+// ---------------------------------------------------------------------------
+static uint8_t bucket_of(uint32_t key)
+{
+    return ((uint8_t)key ^ (uint8_t)(key >> 8) ^ (uint8_t)(key >> 16)) & (POSE_CACHE_BUCKETS - 1);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool pose_cache_init(pose_cache_t *cache, void *pool, uint16_t pool_bytes, uint8_t vertex_count)
+{
+    uint16_t entry_bytes = sizeof(pose_entry_t) + (uint16_t)vertex_count * 3 * sizeof(int16_t);
+
+    cache->vertex_count = vertex_count;
+    cache->capacity = pool_bytes / entry_bytes;
+    cache->entries = (pose_entry_t *)pool;
+    cache->vertices = (int16_t *)(cache->entries + cache->capacity);
+    cache->hits = 0;
+    cache->misses = 0;
+    pose_cache_clear(cache);
+    return cache->capacity > 0;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void pose_cache_clear(pose_cache_t *cache)
+{
+    uint8_t i;
+
+    for (i = 0; i < POSE_CACHE_BUCKETS; i++) {
+        cache->buckets[i] = POSE_CACHE_NONE;
+    }
+    cache->used = 0;
+    cache->hand = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Pick a victim with the clock sweep and unlink it from its bucket
+// ---------------------------------------------------------------------------
+static uint16_t evict(pose_cache_t *cache)
+{
+    uint16_t victim;
+    uint16_t *link;
+
+    while (cache->entries[cache->hand].referenced) {
+        cache->entries[cache->hand].referenced = 0;
+        if (++cache->hand == cache->capacity) {
+            cache->hand = 0;
+        }
+    }
+    victim = cache->hand;
+    if (++cache->hand == cache->capacity) {
+        cache->hand = 0;
+    }
+
+    link = &cache->buckets[bucket_of(cache->entries[victim].key)];
+    while (*link != victim) {
+        link = &cache->entries[*link].next;
+    }
+    *link = cache->entries[victim].next;
+
+    return victim;
+}
+
+// ---------------------------------------------------------------------------
+// Find key, or claim an entry for it. Only rendering lookups (touch) count
+// towards the statistics and the clock bits.
+// ---------------------------------------------------------------------------
+static bool lookup(pose_cache_t *cache, uint32_t key, int16_t **vertices, bool touch)
+{
+    uint8_t bucket = bucket_of(key);
+    uint16_t i = cache->buckets[bucket];
+    uint16_t stride = (uint16_t)cache->vertex_count * 3;
+
+    // a pool too small for one pose: nothing to look in, nothing to evict
+    if (cache->capacity == 0) {
+        if (touch) {
+            cache->misses++;
+        }
+        *vertices = NULL;
+        return false;
+    }
+
+    while (i != POSE_CACHE_NONE) {
+        if (cache->entries[i].key == key) {
+            if (touch) {
+                cache->entries[i].referenced = 1;
+                cache->hits++;
+            }
+            *vertices = cache->vertices + i * stride;
+            return true;
+        }
+        i = cache->entries[i].next;
+    }
+
+    if (touch) {
+        cache->misses++;
+    }
+    if (cache->used < cache->capacity) {
+        i = cache->used++;
+    } else {
+        i = evict(cache);
+    }
+    cache->entries[i].key = key;
+    cache->entries[i].referenced = 0;
+    cache->entries[i].next = cache->buckets[bucket];
+    cache->buckets[bucket] = i;
+
+    *vertices = cache->vertices + i * stride;
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool pose_cache_fetch(pose_cache_t *cache, uint32_t key, int16_t **vertices)
+{
+    return lookup(cache, key, vertices, true);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool pose_cache_warm(pose_cache_t *cache, uint32_t key, int16_t **vertices)
+{
+    return lookup(cache, key, vertices, false);
+}
@@ -0,0 +1,66 @@
+// ---------------------------------------------------------------------------
+// pose_cache.h
+//
+// Bounded cache of projected vertex sets ("poses") keyed by the quantized
+// orientation they were computed for. Any motion that revisits an
+// orientation - the steady spin, a reversed spin, interactive rotation -
+// reuses the transformed vertices instead of rotating them again.
+//
+// Entries live in a caller-supplied byte pool, so the capacity follows the
+// vertex count of the mesh. When the pool is full, a clock (second chance)
+// sweep picks the entry to evict.
+// ---------------------------------------------------------------------------
+
+#ifndef POSE_CACHE_H
+#define POSE_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Angles are divided by (1 << POSE_ANGLE_SHIFT) before keying.
+// 0 keeps every distinct orientation apart.
+#define POSE_ANGLE_SHIFT 0
+
+// Build a cache key from three 8-bit binary angles
+#define pose_key(ax, ay, az) \
+    (((uint32_t)((uint8_t)(ax) >> POSE_ANGLE_SHIFT) << 16) | \
+     ((uint16_t)((uint8_t)(ay) >> POSE_ANGLE_SHIFT) <<  8) | \
+                ((uint8_t)(az) >> POSE_ANGLE_SHIFT))
+
+#define POSE_CACHE_BUCKETS 64   // power of two
+#define POSE_CACHE_NONE 0xFFFF
+
+typedef struct {
+    uint32_t key;
+    uint16_t next;          // next entry in the same hash bucket
+    uint8_t  referenced;    // clock bit, set on every hit
+} pose_entry_t;
+
+typedef struct {
+    pose_entry_t *entries;
+    int16_t *vertices;      // capacity * vertex_count * 3 values (x, y, z)
+    uint16_t buckets[POSE_CACHE_BUCKETS];
+    uint16_t capacity;
+    uint16_t used;
+    uint16_t hand;          // clock hand
+    uint8_t  vertex_count;
+    uint32_t hits;
+    uint32_t misses;
+} pose_cache_t;
+
+// Carve the pool into entries for poses of vertex_count vertices each.
+// Returns false when the pool cannot hold a single pose; the cache then
+// stays empty and every fetch is a miss with *vertices set to NULL.
+bool pose_cache_init(pose_cache_t *cache, void *pool, uint16_t pool_bytes, uint8_t vertex_count);
+// Drop every cached pose (counters are kept)
+void pose_cache_clear(pose_cache_t *cache);
+// Point *vertices at the pose stored for key. Returns true on a hit.
+// On a miss an entry is claimed (evicting if needed) and the caller must
+// fill all vertex_count * 3 values before the next call, unless *vertices
+// is NULL (no room at all, see pose_cache_init).
+bool pose_cache_fetch(pose_cache_t *cache, uint32_t key, int16_t **vertices);
+// Same as pose_cache_fetch, for precomputing poses ahead of time: it does
+// not count as a hit or miss and does not protect the entry from eviction.
+bool pose_cache_warm(pose_cache_t *cache, uint32_t key, int16_t **vertices);
+
+#endif // POSE_CACHE_H
@@ -0,0 +1,70 @@
+// ---------------------------------------------------------------------------
+// scene.c
+//
+// Mesh instances with bounding-sphere culling and back-to-front ordering.
+// ---------------------------------------------------------------------------
+
+#include <stdint.h>
+#include "mesh.h"
+#include "scene.h"
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+scene_instance_t *scene_add(scene_t *scene, const mesh_t *mesh, int16_t x, int16_t y, int16_t z,
+                            uint8_t phase, uint8_t scale)
+{
+    scene_instance_t *instance;
+
+    if (scene->count >= SCENE_MAX_INSTANCES) {
+        return 0;
+    }
+    instance = &scene->instances[scene->count++];
+    instance->mesh = mesh;
+    instance->x = x;
+    instance->y = y;
+    instance->z = z;
+    instance->phase = phase;
+    instance->scale = scale;
+    return instance;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint16_t scene_radius(const scene_instance_t *instance, uint16_t unit)
+{
+    uint16_t r = instance->mesh->radius / unit + 1;
+
+    if (instance->scale != SCENE_SCALE_ONE) {
+        r = (uint16_t)(((uint32_t)r * instance->scale) / SCENE_SCALE_ONE) + 1;
+    }
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void scene_cull_and_sort(scene_t *scene, uint16_t unit, uint16_t width, uint16_t height)
+{
+    uint8_t i, j;
+
+    scene->visible = 0;
+    for (i = 0; i < scene->count; i++) {
+        const scene_instance_t *instance = &scene->instances[i];
+        int16_t r = scene_radius(instance, unit);
+        int16_t cx = instance->x + (int16_t)(width / 2);
+        int16_t cy = instance->y + (int16_t)(height / 2);
+
+        // reject when the sphere lies entirely outside the canvas
+        if (cx + r < 0 || cx - r >= (int16_t)width ||
+            cy + r < 0 || cy - r >= (int16_t)height) {
+            continue;
+        }
+
+        // insertion sort, farthest first
+        j = scene->visible++;
+        while (j > 0 && scene->instances[scene->order[j - 1]].z < instance->z) {
+            scene->order[j] = scene->order[j - 1];
+            j--;
+        }
+        scene->order[j] = i;
+    }
+}
@@ -0,0 +1,42 @@
+// ---------------------------------------------------------------------------
+// scene.h
+//
+// A scene holds several instances of meshes, each with its own position,
+// orientation phase and scale. Before anything is transformed, instances
+// whose bounding sphere misses the canvas are rejected and the rest are
+// ordered back to front by the depth of their centre.
+// ---------------------------------------------------------------------------
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdint.h>
+#include "mesh.h"
+
+#define SCENE_MAX_INSTANCES 16
+#define SCENE_SCALE_ONE 64     // instance scale of 1.0
+
+typedef struct {
+    const mesh_t *mesh;
+    int16_t x, y, z;           // centre, in pixels from the middle of the canvas
+    uint8_t phase;             // added to every rotation angle
+    uint8_t scale;             // SCENE_SCALE_ONE is the mesh's own size
+} scene_instance_t;
+
+typedef struct {
+    scene_instance_t instances[SCENE_MAX_INSTANCES];
+    uint8_t count;
+    uint8_t order[SCENE_MAX_INSTANCES];  // visible instances, back to front
+    uint8_t visible;
+} scene_t;
+
+// Add an instance, returns it (or 0 when the scene is full)
+scene_instance_t *scene_add(scene_t *scene, const mesh_t *mesh, int16_t x, int16_t y, int16_t z,
+                            uint8_t phase, uint8_t scale);
+// Screen radius of an instance whose mesh vertices are divided by unit
+uint16_t scene_radius(const scene_instance_t *instance, uint16_t unit);
+// Fill scene->order with the instances whose bounding sphere overlaps a
+// width x height canvas, farthest (largest z) first
+void scene_cull_and_sort(scene_t *scene, uint16_t unit, uint16_t width, uint16_t height);
+
+#endif // SCENE_H
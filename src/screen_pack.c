@@ -0,0 +1,83 @@
+// ---------------------------------------------------------------------------
+// screen_pack.c
+//
+// Prebaked screen text blitted from XRAM.
+// ---------------------------------------------------------------------------
+
+#include <rp6502.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "bitmap_graphics_db.h"
+#include "screen_pack.h"
+
+#define IMAGE_HEADER_BYTES 4
+
+// ---------------------------------------------------------------------------
+// Number of images, 0 if there is no pack (leaves port 0 after the count)
+// ---------------------------------------------------------------------------
+static uint8_t pack_count(uint16_t xram_addr)
+{
+    RIA.addr0 = xram_addr;
+    RIA.step0 = 1;
+    if (RIA.rw0 != 'S' || RIA.rw0 != 'P') {
+        return 0;
+    }
+    return RIA.rw0;
+}
+
+// ---------------------------------------------------------------------------
+// XRAM address of image index, port 0 is left at its header
+// ---------------------------------------------------------------------------
+static uint16_t image_addr(uint16_t xram_addr, uint8_t index)
+{
+    uint16_t offset;
+
+    RIA.addr0 = xram_addr + 4 + 2 * index;
+    RIA.step0 = 1;
+    offset = RIA.rw0;
+    offset |= (uint16_t)RIA.rw0 << 8;
+    RIA.addr0 = xram_addr + offset;
+    return xram_addr + offset;
+}
+
+// ---------------------------------------------------------------------------
+// The pack ends with its last image
+// ---------------------------------------------------------------------------
+uint16_t screen_pack_bytes(uint16_t xram_addr)
+{
+    uint8_t count = pack_count(xram_addr);
+    uint16_t last;
+    uint8_t width_bytes, height;
+
+    if (count == 0) {
+        return 0;
+    }
+    last = image_addr(xram_addr, count - 1);
+    width_bytes = RIA.rw0;
+    height = RIA.rw0;
+    return last - xram_addr + IMAGE_HEADER_BYTES + (uint16_t)width_bytes * height;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool screen_pack_blit(uint16_t xram_addr, uint8_t index, uint16_t x, uint16_t y,
+                      uint16_t buffer_data_address)
+{
+    uint16_t image;
+    uint8_t width_bytes, height, left, bpp;
+
+    if (index >= pack_count(xram_addr)) {
+        return false;
+    }
+    image = image_addr(xram_addr, index);
+    width_bytes = RIA.rw0;
+    height = RIA.rw0;
+    left = RIA.rw0;
+    bpp = RIA.rw0;
+    if (bpp != canvas_context()->bpp || (x & (8 / bpp - 1)) != left) {
+        return false;
+    }
+    blit2buffer(image + IMAGE_HEADER_BYTES, x - left, y, (uint16_t)width_bytes * 8 / bpp, height,
+                buffer_data_address);
+    return true;
+}
@@ -0,0 +1,30 @@
+// ---------------------------------------------------------------------------
+// screen_pack.h
+//
+// Fixed screen text (title, key help, prompts) rendered on the host by
+// tools/bake_screens.py and loaded into XRAM by the ROM. Showing one is a
+// blit: every byte is read and written once, instead of a read-modify-write
+// per pixel of text. Binary layout (little-endian):
+//
+//   screen pack:  'S' 'P' count 0  uint16 offset[count]   (from pack start)
+//   image:        uint8 width_bytes  uint8 height  uint8 left  uint8 bpp
+//                 uint8 rows[height][width_bytes]
+//
+// The text of an image starts left pixels into its first byte.
+// ---------------------------------------------------------------------------
+
+#ifndef SCREEN_PACK_H
+#define SCREEN_PACK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Bytes of XRAM taken by the pack at xram_addr, 0 if there is no pack
+uint16_t screen_pack_bytes(uint16_t xram_addr);
+// Blit image number index so that its text starts at x, y. Returns false
+// (draw the text instead) when there is no such image, it was baked for
+// another colour depth or x is not where the image can be byte-aligned.
+bool screen_pack_blit(uint16_t xram_addr, uint8_t index, uint16_t x, uint16_t y,
+                      uint16_t buffer_data_address);
+
+#endif // SCREEN_PACK_H
@@ -0,0 +1,146 @@
+// ---------------------------------------------------------------------------
+// stats.c
+//
+// Frame statistics measured in vsync ticks.
+// ---------------------------------------------------------------------------
+
+#include <rp6502.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "stats.h"
+
+stats_t stats;
+
+static bool report = false;
+
+static uint16_t window_frames = 0;
+static uint16_t window_poses = 0;
+static uint16_t window_ticks = 0;
+static uint16_t window_erase_ticks = 0;
+static uint8_t last_vsync = 0;
+
+// the frame in progress
+static uint8_t frame_vsync = 0;
+static uint8_t frame_poses = 0;
+static uint8_t frame_erase_ticks = 0;
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void stats_reset(uint8_t mode)
+{
+    stats.mode = mode;
+    window_frames = 0;
+    window_poses = 0;
+    window_ticks = 0;
+    window_erase_ticks = 0;
+    last_vsync = RIA.vsync;
+    frame_vsync = last_vsync;
+    frame_poses = 0;
+    frame_erase_ticks = 0;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void stats_set_report(bool on)
+{
+    report = on;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void stats_frame_rendered(void)
+{
+    uint8_t vsync = RIA.vsync;
+
+    window_frames++;
+    stats.total_frames++;
+    if (report) {
+        printf("@F %u %u %u %u\n", stats.mode, (uint8_t)(vsync - frame_vsync),
+               frame_poses, frame_erase_ticks);
+    }
+    frame_vsync = vsync;
+    frame_poses = 0;
+    frame_erase_ticks = 0;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void stats_poses_simulated(uint8_t count)
+{
+    window_poses += count;
+    frame_poses += count;
+    stats.total_poses += count;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void stats_erase_ticks(uint8_t ticks)
+{
+    window_erase_ticks += ticks;
+    frame_erase_ticks += ticks;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void stats_governor(uint8_t level, uint16_t window_ticks)
+{
+    if (report) {
+        printf("@G %u %u %u\n", stats.mode, level, window_ticks);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void stats_governor_manual(uint8_t level)
+{
+    if (report) {
+        printf("@M %u %u\n", stats.mode, level);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void stats_update(uint8_t mode)
+{
+    uint8_t vsync = RIA.vsync;
+
+    window_ticks += (uint8_t)(vsync - last_vsync);
+    last_vsync = vsync;
+
+    if (mode != stats.mode) {
+        // numbers of a mix of modes are of no use
+        stats_reset(mode);
+        return;
+    }
+    if (window_ticks < STATS_WINDOW_TICKS) {
+        return;
+    }
+
+    stats.frames = window_frames;
+    stats.poses = window_poses;
+    stats.ticks = window_ticks;
+    stats.erase_ticks = window_erase_ticks;
+    if (report) {
+        printf("@W %u %u %u %u %u\n", stats.mode, stats.frames, stats.poses,
+               stats.ticks, stats.erase_ticks);
+    }
+    window_frames = 0;
+    window_poses = 0;
+    window_ticks = 0;
+    window_erase_ticks = 0;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint8_t stats_fps(void)
+{
+    return stats.ticks ? (uint32_t)stats.frames * 60 / stats.ticks : 0;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint8_t stats_pps(void)
+{
+    return stats.ticks ? (uint32_t)stats.poses * 60 / stats.ticks : 0;
+}
@@ -0,0 +1,58 @@
+// ---------------------------------------------------------------------------
+// stats.h
+//
+// Frame statistics measured in vsync ticks (60 per second).
+//
+// Frames rendered and poses simulated are counted separately: with a fixed
+// simulation step the animation speed no longer depends on the render
+// rate, so throughput comparisons across drawing modes use the frame
+// count while the pose count shows the simulation kept up.
+//
+// When reporting is on, the numbers go to the console as lines that
+// tools/rp6502.py profile collects on the host:
+//
+//   @F <mode> <frame ticks> <poses> <erase ticks>       after every frame
+//   @W <mode> <frames> <poses> <ticks> <erase ticks>     after every window
+//   @G <mode> <level> <window ticks>                      on a governor decision
+//   @M <mode> <level>                                     when [G] turns it on or off
+// ---------------------------------------------------------------------------
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define STATS_WINDOW_TICKS 120 // measure over two seconds
+
+typedef struct {
+    uint8_t  mode;
+    uint16_t frames;        // rendered in the last window
+    uint16_t poses;         // simulated in the last window
+    uint16_t ticks;         // length of the last window
+    uint16_t erase_ticks;   // spent erasing frames in the last window
+    uint32_t total_frames;
+    uint32_t total_poses;
+} stats_t;
+
+extern stats_t stats;
+
+// Start measuring from now
+void stats_reset(uint8_t mode);
+// Print stats lines on the console (off by default)
+void stats_set_report(bool report);
+void stats_frame_rendered(void);
+void stats_poses_simulated(uint8_t count);
+// Ticks that passed while erasing a frame (sampled, exact on average)
+void stats_erase_ticks(uint8_t ticks);
+// The frame governor moved to level after a window of window_ticks
+void stats_governor(uint8_t level, uint16_t window_ticks);
+// The governor was turned on or off by hand and the level is now level
+void stats_governor_manual(uint8_t level);
+// Close the window when it is due (or the mode changed)
+void stats_update(uint8_t mode);
+// Rates of the last finished window, per second
+uint8_t stats_fps(void);
+uint8_t stats_pps(void);
+
+#endif // STATS_H
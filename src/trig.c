@@ -0,0 +1,33 @@
+// ---------------------------------------------------------------------------
+// trig.c
+//
+// Quarter-wave sine table indexed by binary angles.
+// ---------------------------------------------------------------------------
+
+#include <stdint.h>
+#include "trig.h"
+
+// sin(i * 90 / 64 degrees) * 4096, for i = 0..64
+static const int16_t sine_quarter[ANGLE_QUARTER + 1] = {
+       0,  101,  201,  301,  401,  501,  601,  700,
+     799,  897,  995, 1092, 1189, 1285, 1380, 1474,
+    1567, 1660, 1751, 1842, 1931, 2019, 2106, 2191,
+    2276, 2359, 2440, 2520, 2598, 2675, 2751, 2824,
+    2896, 2967, 3035, 3102, 3166, 3229, 3290, 3349,
+    3406, 3461, 3513, 3564, 3612, 3659, 3703, 3745,
+    3784, 3822, 3857, 3889, 3920, 3948, 3973, 3996,
+    4017, 4036, 4052, 4065, 4076, 4085, 4091, 4095,
+    4096
+};
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+int16_t isin(angle_t a)
+{
+    uint8_t i = a & (ANGLE_QUARTER - 1);
+
+    if (a & ANGLE_QUARTER) { // 2nd and 4th quadrant run backwards
+        i = ANGLE_QUARTER - i;
+    }
+    return (a & ANGLE_HALF) ? -sine_quarter[i] : sine_quarter[i];
+}
@@ -0,0 +1,28 @@
+// ---------------------------------------------------------------------------
+// trig.h
+//
+// Binary angles and fixed-point sine/cosine.
+//
+// An angle_t divides the full turn into 256 units, so angle arithmetic is
+// plain uint8_t arithmetic and wraps around for free. Sine and cosine come
+// from a single quarter-wave table (65 entries, 130 bytes); the other
+// quadrants and the cosine follow from symmetry.
+//
+// Results are in 4.12 fixed point: 4096 is 1.0.
+// ---------------------------------------------------------------------------
+
+#ifndef TRIG_H
+#define TRIG_H
+
+#include <stdint.h>
+
+typedef uint8_t angle_t;
+
+#define ANGLE_QUARTER 64   // 90 degrees
+#define ANGLE_HALF 128     // 180 degrees
+#define TRIG_ONE 4096      // 1.0 in 4.12 fixed point
+
+int16_t isin(angle_t a);
+#define icos(a) isin((angle_t)((a) + ANGLE_QUARTER))
+
+#endif // TRIG_H
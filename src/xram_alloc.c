@@ -0,0 +1,122 @@
+// ---------------------------------------------------------------------------
+// xram_alloc.c
+//
+// Named, non-overlapping regions of extended RAM.
+// ---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "xram_alloc.h"
+
+#define XRAM_END 0x10000UL
+
+// kept in address order
+static xram_region_t regions[XRAM_MAX_REGIONS];
+static uint8_t region_count = 0;
+
+// ---------------------------------------------------------------------------
+// Insert a region that is known to fit at position index
+// ---------------------------------------------------------------------------
+static void insert(uint8_t index, const char *name, uint16_t addr, uint16_t size)
+{
+    uint8_t i;
+
+    for (i = region_count; i > index; i--) {
+        regions[i] = regions[i - 1];
+    }
+    regions[index].name = name;
+    regions[index].addr = addr;
+    regions[index].size = size;
+    region_count++;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void xram_reset(void)
+{
+    region_count = 0;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+bool xram_reserve_at(const char *name, uint16_t addr, uint16_t size)
+{
+    uint32_t end = (uint32_t)addr + size;
+    uint8_t i;
+
+    if (region_count >= XRAM_MAX_REGIONS || end > XRAM_END) {
+        printf("XRAM: no room for %s at %04X\n", name, addr);
+        return false;
+    }
+    for (i = 0; i < region_count; i++) {
+        if (regions[i].addr >= end) {
+            break;
+        }
+        if ((uint32_t)regions[i].addr + regions[i].size > addr) {
+            printf("XRAM: %s at %04X overlaps %s\n", name, addr, regions[i].name);
+            return false;
+        }
+    }
+    insert(i, name, addr, size);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint16_t xram_alloc(const char *name, uint16_t size, uint16_t align)
+{
+    uint32_t addr = 0;
+    uint8_t i;
+
+    if (region_count >= XRAM_MAX_REGIONS) {
+        return XRAM_NONE;
+    }
+    // first fit: try the gap in front of every region, then the tail
+    for (i = 0; i <= region_count; i++) {
+        uint32_t limit = (i < region_count) ? regions[i].addr : XRAM_END;
+        addr = (addr + align - 1) & ~(uint32_t)(align - 1);
+        if (addr + size <= limit) {
+            insert(i, name, (uint16_t)addr, size);
+            return (uint16_t)addr;
+        }
+        if (i < region_count) {
+            addr = (uint32_t)regions[i].addr + regions[i].size;
+        }
+    }
+    printf("XRAM: no room for %s (%u bytes)\n", name, size);
+    return XRAM_NONE;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+uint16_t xram_largest_free(void)
+{
+    uint32_t addr = 0;
+    uint32_t largest = 0;
+    uint8_t i;
+
+    for (i = 0; i <= region_count; i++) {
+        uint32_t limit = (i < region_count) ? regions[i].addr : XRAM_END;
+        if (limit - addr > largest) {
+            largest = limit - addr;
+        }
+        if (i < region_count) {
+            addr = (uint32_t)regions[i].addr + regions[i].size;
+        }
+    }
+    return (largest > 0xFFFF) ? 0xFFFF : (uint16_t)largest;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void xram_report(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < region_count; i++) {
+        printf("XRAM %04X-%04X %s\n", regions[i].addr,
+               (uint16_t)(regions[i].addr + regions[i].size - 1), regions[i].name);
+    }
+    printf("XRAM largest free block: %u bytes\n", xram_largest_free());
+}
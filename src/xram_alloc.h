@@ -0,0 +1,40 @@
+// ---------------------------------------------------------------------------
+// xram_alloc.h
+//
+// Bookkeeping for the 64K of extended RAM. Every user of XRAM - frame
+// buffers, device mappings, the canvas structure, loaded assets - takes a
+// named region from here instead of a hand-picked address, so regions can
+// not overlap when the canvas size, colour depth or buffer count changes.
+//
+// Regions are never freed; xram_reset() starts a new layout.
+// ---------------------------------------------------------------------------
+
+#ifndef XRAM_ALLOC_H
+#define XRAM_ALLOC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define XRAM_MAX_REGIONS 16
+#define XRAM_NONE 0xFFFF    // returned when a region does not fit
+
+typedef struct {
+    const char *name;
+    uint16_t addr;
+    uint16_t size;
+} xram_region_t;
+
+// Forget every region
+void xram_reset(void);
+// Claim size bytes at a fixed address (ROM assets, firmware defaults).
+// Fails when the region runs past the end of XRAM or overlaps another one.
+bool xram_reserve_at(const char *name, uint16_t addr, uint16_t size);
+// Claim size bytes at the lowest free address that is a multiple of align
+// (a power of two). Returns XRAM_NONE when there is no room.
+uint16_t xram_alloc(const char *name, uint16_t size, uint16_t align);
+// Size of the largest free gap
+uint16_t xram_largest_free(void);
+// Print the regions in address order
+void xram_report(void);
+
+#endif // XRAM_ALLOC_H
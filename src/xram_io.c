@@ -0,0 +1,114 @@
+// ---------------------------------------------------------------------------
+// xram_io.c
+//
+// Unrolled bulk transfers through the RIA ports.
+// ---------------------------------------------------------------------------
+
+#include <rp6502.h>
+#include <stdint.h>
+#include "xram_io.h"
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void xram_fill(uint16_t addr, uint8_t value, uint16_t count)
+{
+    uint8_t odd = count & 7;
+    uint16_t blocks = count >> 3;
+
+    RIA.addr1 = addr;
+    RIA.step1 = 1;
+    while (odd--) {
+        RIA.rw1 = value;
+    }
+    while (blocks--) {
+        RIA.rw1 = value;
+        RIA.rw1 = value;
+        RIA.rw1 = value;
+        RIA.rw1 = value;
+        RIA.rw1 = value;
+        RIA.rw1 = value;
+        RIA.rw1 = value;
+        RIA.rw1 = value;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Constant offsets from p, so the pointer moves once per block
+// ---------------------------------------------------------------------------
+void xram_write(uint16_t addr, const void *src, uint16_t count)
+{
+    const uint8_t *p = (const uint8_t *)src;
+    uint8_t odd = count & 7;
+    uint16_t blocks = count >> 3;
+
+    RIA.addr1 = addr;
+    RIA.step1 = 1;
+    while (odd--) {
+        RIA.rw1 = *p++;
+    }
+    while (blocks--) {
+        RIA.rw1 = p[0];
+        RIA.rw1 = p[1];
+        RIA.rw1 = p[2];
+        RIA.rw1 = p[3];
+        RIA.rw1 = p[4];
+        RIA.rw1 = p[5];
+        RIA.rw1 = p[6];
+        RIA.rw1 = p[7];
+        p += 8;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+void xram_read(void *dst, uint16_t addr, uint16_t count)
+{
+    uint8_t *p = (uint8_t *)dst;
+    uint8_t odd = count & 7;
+    uint16_t blocks = count >> 3;
+
+    RIA.addr0 = addr;
+    RIA.step0 = 1;
+    while (odd--) {
+        *p++ = RIA.rw0;
+    }
+    while (blocks--) {
+        p[0] = RIA.rw0;
+        p[1] = RIA.rw0;
+        p[2] = RIA.rw0;
+        p[3] = RIA.rw0;
+        p[4] = RIA.rw0;
+        p[5] = RIA.rw0;
+        p[6] = RIA.rw0;
+        p[7] = RIA.rw0;
+        p += 8;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Byte by byte in address order, so an overlapping copy to a higher
+// address repeats the bytes in between (like an LZ match)
+// ---------------------------------------------------------------------------
+void xram_copy(uint16_t dst, uint16_t src, uint16_t count)
+{
+    uint8_t odd = count & 7;
+    uint16_t blocks = count >> 3;
+
+    RIA.addr0 = src;
+    RIA.step0 = 1;
+    RIA.addr1 = dst;
+    RIA.step1 = 1;
+    while (odd--) {
+        RIA.rw1 = RIA.rw0;
+    }
+    while (blocks--) {
+        RIA.rw1 = RIA.rw0;
+        RIA.rw1 = RIA.rw0;
+        RIA.rw1 = RIA.rw0;
+        RIA.rw1 = RIA.rw0;
+        RIA.rw1 = RIA.rw0;
+        RIA.rw1 = RIA.rw0;
+        RIA.rw1 = RIA.rw0;
+        RIA.rw1 = RIA.rw0;
+    }
+}
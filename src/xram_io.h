@@ -0,0 +1,24 @@
+// ---------------------------------------------------------------------------
+// xram_io.h
+//
+// Bulk moves between RAM and XRAM through the RIA ports, for any length.
+// The odd bytes go first, then the rest 8 at a time, so a loop pass costs
+// one counter update per 8 port accesses. Like the graphics library, reads
+// use port 0 and writes port 1, and the step of a port used is set to 1.
+// ---------------------------------------------------------------------------
+
+#ifndef XRAM_IO_H
+#define XRAM_IO_H
+
+#include <stdint.h>
+
+// Set count bytes from addr to value
+void xram_fill(uint16_t addr, uint8_t value, uint16_t count);           // [1]
+// Copy count bytes of RAM to addr
+void xram_write(uint16_t addr, const void *src, uint16_t count);        // [1]
+// Copy count bytes from addr to RAM
+void xram_read(void *dst, uint16_t addr, uint16_t count);               // [0]
+// Copy count bytes from src to dst in XRAM, first byte first
+void xram_copy(uint16_t dst, uint16_t src, uint16_t count);             // [0 1]
+
+#endif // XRAM_IO_H
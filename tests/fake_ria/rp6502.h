@@ -0,0 +1,110 @@
+// ---------------------------------------------------------------------------
+// rp6502.h
+//
+// Stand-in for the llvm-mos header in host tests, built as C++. The RIA
+// struct has the two XRAM ports, and reading or writing rw0 / rw1 moves
+// through a 64K fake XRAM by the port's step, like the real ones. Every
+// access is counted. The video mode struct and xram0_struct_set go
+// through port 0 as in llvm-mos, xregn only returns.
+// ---------------------------------------------------------------------------
+
+#ifndef _RP6502_H
+#define _RP6502_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+extern uint8_t xram[0x10000];
+
+typedef struct {
+    unsigned long reads;    // rw0 / rw1 read
+    unsigned long writes;   // rw0 / rw1 written
+    unsigned long setups;   // addr or step set
+} fake_ria_counts_t;
+
+extern fake_ria_counts_t fake_ria_counts;
+
+struct fake_port {
+    uint16_t addr;
+    int8_t step;
+};
+
+struct fake_rw {
+    fake_port *port;
+    operator uint8_t() const
+    {
+        uint8_t value = xram[port->addr];
+        port->addr += port->step;
+        fake_ria_counts.reads++;
+        return value;
+    }
+    fake_rw &operator=(uint8_t value)
+    {
+        xram[port->addr] = value;
+        port->addr += port->step;
+        fake_ria_counts.writes++;
+        return *this;
+    }
+    fake_rw &operator=(const fake_rw &other)
+    {
+        return *this = (uint8_t)other;
+    }
+};
+
+struct fake_addr {
+    fake_port *port;
+    operator uint16_t() const { return port->addr; }
+    fake_addr &operator=(uint16_t value)
+    {
+        port->addr = value;
+        fake_ria_counts.setups++;
+        return *this;
+    }
+};
+
+struct fake_step {
+    fake_port *port;
+    operator int8_t() const { return port->step; }
+    fake_step &operator=(int8_t value)
+    {
+        port->step = value;
+        fake_ria_counts.setups++;
+        return *this;
+    }
+};
+
+struct fake_ria {
+    fake_port port0, port1;
+    fake_rw rw0{&port0}, rw1{&port1};
+    fake_step step0{&port0}, step1{&port1};
+    fake_addr addr0{&port0}, addr1{&port1};
+};
+
+extern fake_ria RIA;
+
+typedef struct {
+    bool x_wrap;
+    bool y_wrap;
+    int16_t x_pos_px;
+    int16_t y_pos_px;
+    int16_t width_px;
+    int16_t height_px;
+    uint16_t xram_data_ptr;
+    uint16_t xram_palette_ptr;
+} vga_mode3_config_t;
+
+#define xram0_struct_set(addr, type, member, val) do { \
+    RIA.addr0 = (unsigned)(addr) + offsetof(type, member); \
+    RIA.step0 = 1; \
+    RIA.rw0 = (uint8_t)(val); \
+    if (sizeof(((type *)0)->member) == 2) { \
+        RIA.rw0 = (uint8_t)((unsigned)(val) >> 8); \
+    } \
+} while (0)
+
+inline int xregn(char, char, unsigned char, unsigned, ...)
+{
+    return 0;
+}
+
+#endif // _RP6502_H
@@ -0,0 +1,144 @@
+// ---------------------------------------------------------------------------
+// test_asset_stream.c
+//
+// Host test of src/asset_stream.c on a temporary file: reads across chunk
+// boundaries, seeking back to a header, the end of the file and the
+// stalls count with and without a prefetch between reads.
+// ---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "asset_stream.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static char path[] = "/tmp/test_asset_streamXXXXXX";
+static uint8_t file[3 * ASSET_CHUNK_BYTES + 100];
+
+// ---------------------------------------------------------------------------
+// Write size bytes of the pattern to the temporary file
+// ---------------------------------------------------------------------------
+static void make_file(uint16_t size)
+{
+    FILE *f = fopen(path, "wb");
+    fwrite(file, 1, size, f);
+    fclose(f);
+}
+
+// ---------------------------------------------------------------------------
+// Read the whole file in pieces of step bytes and compare
+// ---------------------------------------------------------------------------
+static void test_boundaries(uint16_t size, uint16_t step, bool prefetch)
+{
+    static uint8_t out[sizeof(file) + 64];
+    asset_stream_t stream;
+    uint16_t total = 0;
+    uint16_t count;
+
+    make_file(size);
+    CHECK(asset_stream_open(&stream, path));
+    do {
+        if (prefetch) {
+            asset_stream_prefetch(&stream);
+        }
+        count = asset_stream_read(&stream, out + total, step);
+        total += count;
+        // only the last read comes up short
+        CHECK(count == step || total == size);
+    } while (count == step);
+    CHECK(total == size);
+    CHECK(memcmp(out, file, size) == 0);
+    CHECK(stream.bytes_read == size);
+    CHECK(stream.bytes_loaded == size);
+    // at the end, every read returns nothing
+    CHECK(asset_stream_read(&stream, out, step) == 0);
+    CHECK(asset_stream_prefetch(&stream));
+    if (prefetch) {
+        CHECK(stream.stalls == 0);
+    } else {
+        // every full chunk is followed by a load on the spot, the last
+        // one by the load that finds nothing left
+        CHECK(stream.stalls == size / ASSET_CHUNK_BYTES);
+    }
+    asset_stream_close(&stream);
+    CHECK(stream.fd == -1);
+}
+
+// ---------------------------------------------------------------------------
+// Loop records after a header the way main.c loops the pose stream
+// ---------------------------------------------------------------------------
+static void test_seek_to_header(void)
+{
+    enum { HEADER = 6, RECORD = 100 };
+    uint16_t size = HEADER + 13 * RECORD;
+    asset_stream_t stream;
+    uint8_t header[HEADER];
+    uint8_t record[RECORD];
+    uint16_t i;
+
+    make_file(size);
+    CHECK(asset_stream_open(&stream, path));
+    CHECK(asset_stream_read(&stream, header, HEADER) == HEADER);
+    CHECK(memcmp(header, file, HEADER) == 0);
+    for (i = 0; i < 40; i++) {
+        asset_stream_prefetch(&stream);
+        if (asset_stream_read(&stream, record, RECORD) < RECORD) {
+            CHECK(i % 13 == 0);
+            CHECK(asset_stream_seek(&stream, HEADER));
+            CHECK(asset_stream_read(&stream, record, RECORD) == RECORD);
+        }
+        CHECK(memcmp(record, file + HEADER + i % 13 * RECORD, RECORD) == 0);
+    }
+    // a seek loads the first chunk on the spot, the stream does not stall
+    CHECK(stream.stalls == 0);
+    asset_stream_close(&stream);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static void test_missing_file(void)
+{
+    asset_stream_t stream;
+
+    CHECK(!asset_stream_open(&stream, "/nonexistent/poses.bin"));
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+int main(void)
+{
+    static const uint16_t sizes[] = {
+        0, 1, ASSET_CHUNK_BYTES - 1, ASSET_CHUNK_BYTES, ASSET_CHUNK_BYTES + 1,
+        2 * ASSET_CHUNK_BYTES, sizeof(file)
+    };
+    static const uint16_t steps[] = { 1, 7, 100, ASSET_CHUNK_BYTES, ASSET_CHUNK_BYTES + 3 };
+    uint16_t i, j;
+    int fd;
+
+    fd = mkstemp(path);
+    close(fd);
+    for (i = 0; i < sizeof(file); i++) {
+        file[i] = i * 7 + (i >> 8);
+    }
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (j = 0; j < sizeof(steps) / sizeof(steps[0]); j++) {
+            test_boundaries(sizes[i], steps[j], false);
+            test_boundaries(sizes[i], steps[j], true);
+        }
+    }
+    test_seek_to_header();
+    test_missing_file();
+    unlink(path);
+
+    printf("test_asset_stream: %s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,227 @@
+// ---------------------------------------------------------------------------
+// test_bitmap_graphics.cpp
+//
+// Host test of src/bitmap_graphics_db.c against the fake RIA: shapes drawn
+// directly and through the band renderer, checked pixel by pixel, and
+// lines of every slope, banded and direct, against Bresenham's loop, and
+// the number formatting the overlay uses instead of sprintf.
+// ---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <rp6502.h>
+#include "colors.h"
+#include "bitmap_graphics_db.h"
+
+uint8_t xram[0x10000];
+fake_ria_counts_t fake_ria_counts;
+fake_ria RIA;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#define BUFFER 0x0000
+#define WIDTH 320
+#define HEIGHT 240
+
+// ---------------------------------------------------------------------------
+// A pixel of the 1bpp buffer
+// ---------------------------------------------------------------------------
+static bool lit(uint16_t x, uint16_t y)
+{
+    return xram[BUFFER + y * (WIDTH / 8) + x / 8] & (0x80 >> (x & 7));
+}
+
+// ---------------------------------------------------------------------------
+// Pixels set in rows y0..y1
+// ---------------------------------------------------------------------------
+static uint16_t lit_count(uint16_t y0, uint16_t y1)
+{
+    uint16_t x, y, count = 0;
+
+    for (y = y0; y <= y1; y++) {
+        for (x = 0; x < WIDTH; x++) {
+            count += lit(x, y);
+        }
+    }
+    return count;
+}
+
+// ---------------------------------------------------------------------------
+// The filled shapes, with whole bytes in the middle of their spans
+// ---------------------------------------------------------------------------
+static void draw_shapes(uint16_t color)
+{
+    draw_hline2buffer(color, 3, 2, 100, BUFFER);
+    fill_rect2buffer(color, 5, 10, 60, 20, BUFFER);
+    fill_triangle2buffer(color, 100, 40, 200, 40, 100, 80, BUFFER);
+    fill_circle2buffer(color, 250, 60, 20, BUFFER);
+    fill_rounded_rect2buffer(color, 10, 100, 80, 30, 6, BUFFER);
+}
+
+// ---------------------------------------------------------------------------
+// At 1bpp every colour but black sets a pixel, odd or even, directly and
+// when banded, the same as plot() does for a single pixel
+// ---------------------------------------------------------------------------
+static void test_1bpp_colors(void)
+{
+    static const uint16_t colors[] = { WHITE, DARK_GREEN, DARK_BLUE, 2, 4, 6, 8, 14 };
+    uint16_t reference, i;
+
+    erase_buffer(BUFFER);
+    draw_shapes(1);
+    canvas_flush();
+    reference = lit_count(0, HEIGHT - 1);
+    CHECK(lit_count(2, 2) == 100);
+    CHECK(lit(50, 20) && lit(150, 50) && lit(250, 60) && lit(50, 115));
+
+    for (i = 0; i < sizeof(colors) / sizeof(colors[0]); i++) {
+        erase_buffer(BUFFER);
+        draw_shapes(colors[i]);
+        canvas_flush();
+        CHECK(lit_count(0, HEIGHT - 1) == reference);
+
+        memset(xram + BUFFER, 0x5A, WIDTH / 8 * HEIGHT);
+        CHECK(canvas_record_begin(BUFFER));
+        draw_shapes(colors[i]);
+        canvas_record_end();
+        // what came after a full list was drawn directly
+        canvas_flush();
+        CHECK(lit_count(0, HEIGHT - 1) == reference);
+    }
+
+    erase_buffer(BUFFER);
+    draw_shapes(BLACK);
+    canvas_flush();
+    CHECK(lit_count(0, HEIGHT - 1) == 0);
+}
+
+// ---------------------------------------------------------------------------
+// Bresenham's loop from the lower major end with err starting at dx / 2,
+// the pixels draw_line2buffer has always set
+// ---------------------------------------------------------------------------
+static void reference_line(uint8_t *image, int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    int16_t t, dx, dy, err, ystep;
+
+    if (steep) {
+        t = x0; x0 = y0; y0 = t;
+        t = x1; x1 = y1; y1 = t;
+    }
+    if (x0 > x1) {
+        t = x0; x0 = x1; x1 = t;
+        t = y0; y0 = y1; y1 = t;
+    }
+    dx = x1 - x0;
+    dy = abs(y1 - y0);
+    ystep = (y0 < y1) ? 1 : -1;
+    err = dx / 2;
+    for (; x0 <= x1; x0++) {
+        int16_t x = steep ? y0 : x0;
+        int16_t y = steep ? x0 : y0;
+        if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
+            image[y * (WIDTH / 8) + x / 8] |= 0x80 >> (x & 7);
+        }
+        err -= dy;
+        if (err < 0) {
+            y0 += ystep;
+            err += dx;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Batches of lines in all directions, partly off the canvas, crossing
+// bands: the banded ones must set exactly the pixels of the direct ones
+// ---------------------------------------------------------------------------
+static void test_lines_banded(void)
+{
+    static uint8_t expected[WIDTH / 8 * HEIGHT];
+    uint32_t seed = 1;
+    int16_t line[40][4];
+    uint16_t batch, i, j;
+
+    for (batch = 0; batch < 50; batch++) {
+        for (i = 0; i < 40; i++) {
+            for (j = 0; j < 4; j++) {
+                seed = seed * 1103515245u + 12345u;
+                line[i][j] = (int16_t)((seed >> 16) % ((j & 1) ? HEIGHT + 80 : WIDTH + 80)) - 40;
+            }
+            // short lines, points, horizontal and vertical ones too
+            if (i % 8 == 1) {
+                line[i][2] = line[i][0] + i % 5 - 2;
+                line[i][3] = line[i][1] + i % 3 - 1;
+            } else if (i % 8 == 2) {
+                line[i][3] = line[i][1];
+            } else if (i % 8 == 3) {
+                line[i][2] = line[i][0];
+            }
+        }
+
+        memset(expected, 0, sizeof(expected));
+        for (i = 0; i < 40; i++) {
+            reference_line(expected, line[i][0], line[i][1], line[i][2], line[i][3]);
+        }
+
+        erase_buffer(BUFFER);
+        for (i = 0; i < 40; i++) {
+            draw_line2buffer(WHITE, line[i][0], line[i][1], line[i][2], line[i][3], BUFFER);
+        }
+        canvas_flush();
+        CHECK(memcmp(xram + BUFFER, expected, sizeof(expected)) == 0);
+
+        memset(xram + BUFFER, 0x5A, sizeof(expected));
+        CHECK(canvas_record_begin(BUFFER));
+        for (i = 0; i < 40; i++) {
+            draw_line2buffer(WHITE, line[i][0], line[i][1], line[i][2], line[i][3], BUFFER);
+        }
+        canvas_record_end();
+        CHECK(memcmp(xram + BUFFER, expected, sizeof(expected)) == 0);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// format_int and format_ulong against snprintf
+// ---------------------------------------------------------------------------
+static void test_format(void)
+{
+    static const int16_t ints[] = { 0, 9, 10, -1, -10, 99, 100, 10000, 32767, -32768 };
+    static const uint32_t ulongs[] = { 0, 9, 10, 65535, 65536, 999999999, 1000000000, 4294967295u };
+    char str[FORMAT_ULONG_BYTES], expected[16];
+    uint32_t v;
+    uint8_t i;
+
+    for (i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        snprintf(expected, sizeof(expected), "%d", ints[i]);
+        CHECK(format_int(str, ints[i]) == strlen(expected) && strcmp(str, expected) == 0);
+    }
+    for (i = 0; i < sizeof(ulongs) / sizeof(ulongs[0]); i++) {
+        snprintf(expected, sizeof(expected), "%lu", (unsigned long)ulongs[i]);
+        CHECK(format_ulong(str, ulongs[i]) == strlen(expected) && strcmp(str, expected) == 0);
+    }
+    for (v = 1; v < 4000000000u; v = v * 3 + 1) {
+        snprintf(expected, sizeof(expected), "%lu", (unsigned long)v);
+        CHECK(format_ulong(str, v) == strlen(expected) && strcmp(str, expected) == 0);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+int main(void)
+{
+    init_bitmap_graphics(0xFF00, BUFFER, 0, 1, WIDTH, HEIGHT, 1);
+    test_1bpp_colors();
+    test_lines_banded();
+    test_format();
+
+    printf("test_bitmap_graphics: %s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
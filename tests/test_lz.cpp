@@ -0,0 +1,182 @@
+// ---------------------------------------------------------------------------
+// test_lz.cpp
+//
+// Round trip of tools/lz.py and src/lz.c: data packed by the Python tool is
+// unpacked XRAM to XRAM through the fake RIA and compared. The cases are
+// chosen so the packed streams hold matches that overlap the bytes they
+// produce and literal runs at the 128-byte limit of a token and either
+// side of it; the test counts those tokens to be sure.
+// ---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <rp6502.h>
+#include "lz.h"
+
+uint8_t xram[0x10000];
+fake_ria_counts_t fake_ria_counts;
+fake_ria RIA;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#define SRC 0x8000
+#define DST 0x1000
+#define SENTINEL 0xA5
+
+static const char raw_path[] = "/tmp/test_lz.raw";
+static const char packed_path[] = "/tmp/test_lz.lz";
+static uint8_t data[0x6000];
+static uint8_t packed[0x8000];
+
+static unsigned overlapping = 0; // matches with offset < length
+static unsigned literal_runs[3]; // runs of 127, 128 and 129 bytes in a row
+
+// ---------------------------------------------------------------------------
+// Pack length bytes of data with tools/lz.py, returns the packed length
+// ---------------------------------------------------------------------------
+static size_t pack(size_t length)
+{
+    char command[256];
+    FILE *f = fopen(raw_path, "wb");
+    size_t packed_length;
+
+    fwrite(data, 1, length, f);
+    fclose(f);
+    snprintf(command, sizeof(command), "%s %s -o %s %s > /dev/null",
+             PYTHON, LZ_PY, packed_path, raw_path);
+    if (system(command) != 0) {
+        printf("%s failed\n", command);
+        exit(1);
+    }
+    f = fopen(packed_path, "rb");
+    packed_length = fread(packed, 1, sizeof(packed), f);
+    fclose(f);
+    return packed_length;
+}
+
+// ---------------------------------------------------------------------------
+// Count the token kinds the cases are meant to cover
+// ---------------------------------------------------------------------------
+static void count_tokens(size_t packed_length)
+{
+    size_t i = 4;
+    unsigned run = 0;
+
+    while (i < packed_length) {
+        uint8_t token = packed[i++];
+        if (token & 0x80) {
+            unsigned offset = packed[i] | (packed[i + 1] << 8);
+            if (offset < (unsigned)(token & 0x7F) + 3) {
+                overlapping++;
+            }
+            i += 2;
+            run = 0;
+        } else {
+            i += token + 1;
+            run += token + 1;
+        }
+        // the literals of a 129-byte run come as two tokens
+        if (run >= 127 && run <= 129 && (i >= packed_length || packed[i] & 0x80)) {
+            literal_runs[run - 127]++;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Pack, unpack through the fake RIA and compare
+// ---------------------------------------------------------------------------
+static void round_trip(const char *name, size_t length)
+{
+    size_t packed_length = pack(length);
+    int failed = failures;
+
+    count_tokens(packed_length);
+    memset(xram, SENTINEL, sizeof(xram));
+    memcpy(&xram[SRC], packed, packed_length);
+    CHECK(lz_length_xram(SRC) == length);
+    CHECK(lz_unpack_xram(SRC, DST) == length);
+    CHECK(memcmp(&xram[DST], data, length) == 0);
+    CHECK(xram[DST + length] == SENTINEL);
+    CHECK(xram[DST - 1] == SENTINEL);
+    CHECK(memcmp(&xram[SRC], packed, packed_length) == 0);
+    if (failures != failed) {
+        printf("  in case %s (%zu bytes, %zu packed)\n", name, length, packed_length);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Bytes with no repeated 3-byte sequence lz.py could match
+// ---------------------------------------------------------------------------
+static void noise(uint8_t *out, size_t length, uint32_t seed)
+{
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        out[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+int main(void)
+{
+    static const size_t literal_lengths[] = {1, 2, 127, 128, 129, 255, 256, 257};
+    char name[32];
+    size_t i;
+
+    // one byte repeated: matches at offset 1, up to the longest a token holds
+    memset(data, 0x55, 1000);
+    round_trip("run", 1000);
+
+    // a short pattern: each match starts inside the bytes it copies
+    for (i = 0; i < 1000; i++) {
+        data[i] = "abc"[i % 3];
+    }
+    round_trip("abc", 1000);
+
+    // literal runs at and around the 128 bytes of one token
+    for (i = 0; i < sizeof(literal_lengths) / sizeof(literal_lengths[0]); i++) {
+        noise(data, literal_lengths[i], (uint32_t)i + 1);
+        snprintf(name, sizeof(name), "literals %zu", literal_lengths[i]);
+        round_trip(name, literal_lengths[i]);
+    }
+
+    // literals of 127, 128 and 129 bytes between overlapping matches
+    size_t length = 0;
+    for (i = 127; i <= 129; i++) {
+        noise(&data[length], i, (uint32_t)i);
+        length += i;
+        memset(&data[length], (int)i, 40);
+        length += 40;
+    }
+    round_trip("mixed", length);
+
+    // long and far: offsets beyond 8 bits, the largest buffer
+    noise(data, 0x1000, 7);
+    for (i = 0x1000; i < sizeof(data); i++) {
+        data[i] = data[i - 0x1000 + (i & 0x0F)] ^ (uint8_t)(i >> 11);
+    }
+    round_trip("large", sizeof(data));
+
+    // nothing to unpack
+    round_trip("empty", 0);
+
+    CHECK(overlapping > 0);
+    CHECK(literal_runs[0] > 0);
+    CHECK(literal_runs[1] > 0);
+    CHECK(literal_runs[2] > 0);
+
+    // not LZ data
+    memset(xram, 0, sizeof(xram));
+    CHECK(lz_length_xram(SRC) == 0);
+
+    remove(raw_path);
+    remove(packed_path);
+    printf("test_lz: %s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
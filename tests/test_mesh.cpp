@@ -0,0 +1,114 @@
+// ---------------------------------------------------------------------------
+// test_mesh.cpp
+//
+// Host test of mesh_load_xram in src/mesh.c against the fake RIA: a good
+// mesh loads, and sizes that wrap 16 bits or indices past vertex_count
+// are refused.
+// ---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <rp6502.h>
+#include "mesh.h"
+
+uint8_t xram[0x10000];
+fake_ria_counts_t fake_ria_counts;
+fake_ria RIA;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#define MESH 0x4000
+#define STORAGE_BYTES 1536
+
+static uint8_t storage[STORAGE_BYTES];
+
+// A tetrahedron: 4 vertices, 6 edges, 4 triangles
+static const uint8_t tetra_edges[] = { 0, 1, 1, 2, 2, 0, 0, 3, 1, 3, 2, 3 };
+static const uint8_t tetra_faces[] = { 3, 0, 1, 2,  3, 0, 3, 1,  3, 1, 3, 2,  3, 2, 3, 0 };
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static void put_word(uint16_t addr, uint16_t value)
+{
+    xram[addr] = value;
+    xram[addr + 1] = value >> 8;
+}
+
+// ---------------------------------------------------------------------------
+// Header fields as given, then the tetrahedron's data
+// ---------------------------------------------------------------------------
+static void put_mesh(uint8_t vertex_count, uint16_t edge_count, uint16_t face_count, uint16_t face_bytes)
+{
+    uint16_t addr = MESH + MESH_HEADER_BYTES;
+
+    memset(xram, 0, sizeof(xram));
+    xram[MESH] = 'M';
+    xram[MESH + 1] = '3';
+    xram[MESH + 2] = vertex_count;
+    xram[MESH + 3] = MESH_HAS_FACES;
+    put_word(MESH + 4, edge_count);
+    put_word(MESH + 6, face_count);
+    put_word(MESH + 8, face_bytes);
+    put_word(MESH + 10, 100);
+    addr += 4 * 3 * sizeof(int16_t);
+    memcpy(xram + addr, tetra_edges, sizeof(tetra_edges));
+    memcpy(xram + addr + sizeof(tetra_edges), tetra_faces, sizeof(tetra_faces));
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static bool load(void)
+{
+    mesh_t mesh;
+
+    return mesh_load_xram(&mesh, MESH, storage, sizeof(storage));
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+int main(void)
+{
+    uint16_t faces = MESH + MESH_HEADER_BYTES + 4 * 3 * sizeof(int16_t) + sizeof(tetra_edges);
+
+    put_mesh(4, 6, 4, sizeof(tetra_faces));
+    CHECK(load());
+
+    // edge_count * 2 wraps to a small size
+    put_mesh(4, 0x8003, 4, sizeof(tetra_faces));
+    CHECK(!load());
+    // the sum of the parts wraps
+    put_mesh(4, 6, 4, 0xFFF0);
+    CHECK(!load());
+    // too big for storage without wrapping
+    put_mesh(4, 6, 4, STORAGE_BYTES);
+    CHECK(!load());
+
+    // an edge to vertex 4 of 4
+    put_mesh(4, 6, 4, sizeof(tetra_faces));
+    xram[faces - 1] = 4;
+    CHECK(!load());
+    // a face index past the vertices
+    put_mesh(4, 6, 4, sizeof(tetra_faces));
+    xram[faces + 6] = 200;
+    CHECK(!load());
+    // a face that runs past face_bytes
+    put_mesh(4, 6, 4, sizeof(tetra_faces) - 1);
+    CHECK(!load());
+    // more faces than the records hold
+    put_mesh(4, 6, 5, sizeof(tetra_faces));
+    CHECK(!load());
+    // a face of two vertices
+    put_mesh(4, 6, 4, sizeof(tetra_faces));
+    xram[faces] = 2;
+    CHECK(!load());
+
+    printf("test_mesh: %s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,128 @@
+// ---------------------------------------------------------------------------
+// test_pose_cache.c
+//
+// Host test of src/pose_cache.c: hits and misses, clock eviction in a pool
+// of a few entries, and a pool too small for one pose.
+// ---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include "pose_cache.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#define VERTICES 8
+
+static uint8_t pool[4096];
+static pose_cache_t cache;
+
+// ---------------------------------------------------------------------------
+// Bytes of pool for count poses of VERTICES vertices
+// ---------------------------------------------------------------------------
+static uint16_t pool_for(uint16_t count)
+{
+    return count * (sizeof(pose_entry_t) + VERTICES * 3 * sizeof(int16_t));
+}
+
+// ---------------------------------------------------------------------------
+// Fetch key and check that a hit returns what was stored on the miss
+// ---------------------------------------------------------------------------
+static bool fetch(uint32_t key)
+{
+    int16_t *vertices;
+    bool hit = pose_cache_fetch(&cache, key, &vertices);
+
+    CHECK(vertices != NULL);
+    if (vertices == NULL) {
+        return hit;
+    }
+    if (hit) {
+        CHECK(vertices[0] == (int16_t)key && vertices[VERTICES * 3 - 1] == (int16_t)~key);
+    } else {
+        vertices[0] = (int16_t)key;
+        vertices[VERTICES * 3 - 1] = (int16_t)~key;
+    }
+    return hit;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static void test_hits(void)
+{
+    uint32_t key;
+
+    CHECK(pose_cache_init(&cache, pool, sizeof(pool), VERTICES));
+    CHECK(cache.capacity == sizeof(pool) / pool_for(1));
+    for (key = 0; key < cache.capacity; key++) {
+        CHECK(!fetch(pose_key(key, key * 3, 0)));
+    }
+    for (key = 0; key < cache.capacity; key++) {
+        CHECK(fetch(pose_key(key, key * 3, 0)));
+    }
+    CHECK(cache.hits == cache.capacity && cache.misses == cache.capacity);
+}
+
+// ---------------------------------------------------------------------------
+// Three entries: a key hit since the last sweep survives the next eviction
+// ---------------------------------------------------------------------------
+static void test_eviction(void)
+{
+    CHECK(pose_cache_init(&cache, pool, pool_for(3) + pool_for(1) - 1, VERTICES));
+    CHECK(cache.capacity == 3);
+    fetch(1);
+    fetch(2);
+    fetch(3);
+    CHECK(fetch(1));
+    CHECK(!fetch(4)); // evicts 2: 1 had its second chance
+    CHECK(fetch(1));
+    CHECK(!fetch(2));
+    CHECK(cache.used == 3);
+
+    CHECK(pose_cache_init(&cache, pool, pool_for(1), VERTICES));
+    CHECK(cache.capacity == 1);
+    CHECK(!fetch(5));
+    CHECK(fetch(5));
+    CHECK(!fetch(6));
+    CHECK(!fetch(5));
+}
+
+// ---------------------------------------------------------------------------
+// No room for one pose: init says so, lookups miss without touching the pool
+// ---------------------------------------------------------------------------
+static void test_no_room(void)
+{
+    int16_t *vertices = (int16_t *)pool;
+
+    memset(pool, 0xA5, sizeof(pool));
+    CHECK(!pose_cache_init(&cache, pool, pool_for(1) - 1, VERTICES));
+    CHECK(cache.capacity == 0);
+    CHECK(!pose_cache_fetch(&cache, 1, &vertices));
+    CHECK(vertices == NULL);
+    vertices = (int16_t *)pool;
+    CHECK(!pose_cache_warm(&cache, 1, &vertices));
+    CHECK(vertices == NULL);
+    CHECK(!pose_cache_fetch(&cache, 1, &vertices));
+    CHECK(cache.misses == 2 && cache.hits == 0 && cache.used == 0);
+    CHECK(pool[0] == 0xA5 && pool[pool_for(1) - 2] == 0xA5);
+
+    CHECK(!pose_cache_init(&cache, pool, 0, VERTICES));
+    CHECK(!pose_cache_fetch(&cache, 1, &vertices));
+    CHECK(vertices == NULL);
+}
+
+int main(void)
+{
+    test_hits();
+    test_eviction();
+    test_no_room();
+
+    printf("test_pose_cache: %s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
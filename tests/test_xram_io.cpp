@@ -0,0 +1,255 @@
+// ---------------------------------------------------------------------------
+// test_xram_io.cpp
+//
+// Host test of src/xram_io.c against the fake RIA in fake_ria/rp6502.h:
+// the bytes every call moves, for lengths around the 8 byte blocks and up
+// to 65535, overlapping copies both ways, and the port accesses counted.
+//
+// Port accesses are also compared with plain byte loops: the unrolled
+// routines make the same ones, one per byte and the port setups. What the
+// unroll saves is loop control on the 6502 (one counter test and pointer
+// step per 8 bytes instead of per byte), which the fake RIA cannot see;
+// it has not been measured in cycles.
+// ---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <rp6502.h>
+#include "xram_io.h"
+
+uint8_t xram[0x10000];
+fake_ria_counts_t fake_ria_counts;
+fake_ria RIA;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static uint8_t expect[0x10000];
+static uint8_t ram[0x10000 + 16];
+static uint8_t ram_expect[0x10000 + 16];
+
+static const uint16_t lengths[] = { 0, 1, 2, 7, 8, 9, 15, 16, 17, 255, 256, 4097, 65535 };
+#define LENGTHS (sizeof(lengths) / sizeof(lengths[0]))
+
+// ---------------------------------------------------------------------------
+// Random XRAM, its expected copy and zeroed counts
+// ---------------------------------------------------------------------------
+static void start(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < sizeof(xram); i++) {
+        xram[i] = expect[i] = rand();
+    }
+    memset(&fake_ria_counts, 0, sizeof(fake_ria_counts));
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static void check_counts(unsigned long reads, unsigned long writes, unsigned long setups)
+{
+    CHECK(fake_ria_counts.reads == reads);
+    CHECK(fake_ria_counts.writes == writes);
+    CHECK(fake_ria_counts.setups == setups);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+static void test_fill(uint16_t addr, uint16_t count)
+{
+    uint8_t value = rand();
+    uint16_t i;
+
+    start();
+    for (i = 0; i < count; i++) {
+        expect[(uint16_t)(addr + i)] = value;
+    }
+    xram_fill(addr, value, count);
+    CHECK(memcmp(xram, expect, sizeof(xram)) == 0);
+    check_counts(0, count, 2);
+}
+
+// ---------------------------------------------------------------------------
+// From an odd RAM address, so no alignment is assumed
+// ---------------------------------------------------------------------------
+static void test_write(uint16_t addr, uint16_t count)
+{
+    const uint8_t *src = ram + 3;
+    uint16_t i;
+
+    start();
+    for (i = 0; i < count; i++) {
+        expect[(uint16_t)(addr + i)] = src[i];
+    }
+    xram_write(addr, src, count);
+    CHECK(memcmp(xram, expect, sizeof(xram)) == 0);
+    check_counts(0, count, 2);
+}
+
+// ---------------------------------------------------------------------------
+// The RAM around the count bytes must stay as it was
+// ---------------------------------------------------------------------------
+static void test_read(uint16_t addr, uint16_t count)
+{
+    uint8_t *dst = ram + 5;
+    uint16_t i;
+
+    start();
+    memcpy(ram_expect, ram, sizeof(ram));
+    for (i = 0; i < count; i++) {
+        ram_expect[5 + i] = xram[(uint16_t)(addr + i)];
+    }
+    xram_read(dst, addr, count);
+    CHECK(memcmp(ram, ram_expect, sizeof(ram)) == 0);
+    CHECK(memcmp(xram, expect, sizeof(xram)) == 0);
+    check_counts(count, 0, 2);
+}
+
+// ---------------------------------------------------------------------------
+// Byte by byte from the first byte, which is what an overlapping copy to
+// a higher address must repeat
+// ---------------------------------------------------------------------------
+static void test_copy(uint16_t dst, uint16_t src, uint16_t count)
+{
+    uint16_t i;
+
+    start();
+    for (i = 0; i < count; i++) {
+        expect[(uint16_t)(dst + i)] = expect[(uint16_t)(src + i)];
+    }
+    xram_copy(dst, src, count);
+    CHECK(memcmp(xram, expect, sizeof(xram)) == 0);
+    check_counts(count, count, 4);
+}
+
+// ---------------------------------------------------------------------------
+// The cases an LZ match and a scroll rely on, spelled out
+// ---------------------------------------------------------------------------
+static void test_overlap(void)
+{
+    static const uint8_t pattern[] = { 1, 2, 3 };
+    uint16_t i;
+
+    // 3 bytes back, 13 long: the pattern repeats
+    start();
+    memcpy(xram + 0x1000, pattern, 3);
+    xram_copy(0x1003, 0x1000, 13);
+    for (i = 0; i < 16; i++) {
+        CHECK(xram[0x1000 + i] == pattern[i % 3]);
+    }
+
+    // one byte back: a run of the first byte
+    start();
+    xram[0x2000] = 0xA5;
+    xram_copy(0x2001, 0x2000, 100);
+    for (i = 0; i <= 100; i++) {
+        CHECK(xram[0x2000 + i] == 0xA5);
+    }
+
+    // to a lower address: like memmove
+    start();
+    memmove(expect + 0x3000, expect + 0x3005, 50);
+    xram_copy(0x3000, 0x3005, 50);
+    CHECK(memcmp(xram, expect, sizeof(xram)) == 0);
+}
+
+// ---------------------------------------------------------------------------
+// The routines as plain byte loops, to compare the port work with
+// ---------------------------------------------------------------------------
+static void byte_loop_write(uint16_t addr, const uint8_t *src, uint16_t count)
+{
+    RIA.addr1 = addr;
+    RIA.step1 = 1;
+    while (count--) {
+        RIA.rw1 = *src++;
+    }
+}
+
+static void byte_loop_read(uint8_t *dst, uint16_t addr, uint16_t count)
+{
+    RIA.addr0 = addr;
+    RIA.step0 = 1;
+    while (count--) {
+        *dst++ = RIA.rw0;
+    }
+}
+
+static void byte_loop_copy(uint16_t dst, uint16_t src, uint16_t count)
+{
+    RIA.addr0 = src;
+    RIA.step0 = 1;
+    RIA.addr1 = dst;
+    RIA.step1 = 1;
+    while (count--) {
+        RIA.rw1 = RIA.rw0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Same bytes and same port accesses as the byte loops
+// ---------------------------------------------------------------------------
+static void test_against_byte_loops(uint16_t count)
+{
+    static uint8_t loop_xram[0x10000];
+    static uint8_t loop_ram[0x10000];
+    fake_ria_counts_t unrolled, loop;
+
+    start();
+    xram_write(0x1000, ram, count);
+    xram_read(ram_expect, 0x1000, count);
+    xram_copy(0x1001, 0x1000, count);
+    unrolled = fake_ria_counts;
+    memcpy(loop_xram, xram, sizeof(xram));
+
+    memcpy(xram, expect, sizeof(xram));
+    memset(&fake_ria_counts, 0, sizeof(fake_ria_counts));
+    byte_loop_write(0x1000, ram, count);
+    byte_loop_read(loop_ram, 0x1000, count);
+    byte_loop_copy(0x1001, 0x1000, count);
+    loop = fake_ria_counts;
+
+    CHECK(memcmp(xram, loop_xram, sizeof(xram)) == 0);
+    CHECK(memcmp(ram_expect, loop_ram, count) == 0);
+    CHECK(unrolled.reads == loop.reads && loop.reads == 2ul * count);
+    CHECK(unrolled.writes == loop.writes && loop.writes == 2ul * count);
+    CHECK(unrolled.setups == loop.setups && loop.setups == 8);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+int main(void)
+{
+    static const int16_t offsets[] = { 1, 3, 8, 9, -1, -8, -9, 2000 };
+    uint32_t i;
+    uint8_t j, k;
+
+    srand(1);
+    for (i = 0; i < sizeof(ram); i++) {
+        ram[i] = rand();
+    }
+    for (j = 0; j < LENGTHS; j++) {
+        uint16_t count = lengths[j];
+        // the port addresses wrap at the top of XRAM
+        uint16_t addr = (j & 1) ? 0x8000 + j : 0xFFFF - j;
+        test_fill(addr, count);
+        test_write(addr, count);
+        test_read(addr, count);
+        for (k = 0; k < sizeof(offsets) / sizeof(offsets[0]); k++) {
+            test_copy(addr + offsets[k], addr, count);
+        }
+    }
+    test_overlap();
+    for (j = 0; j < LENGTHS; j++) {
+        test_against_byte_loops(lengths[j]);
+    }
+
+    printf("test_xram_io: %s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: Unlicense
+
+# Precompute a long tumbling animation into a pose stream file, played back
+# from the USB drive by src/main.c through src/asset_stream.c.
+#
+# Stream layout (little-endian):
+#
+#   'P' 'S' vertex_count 0  uint16 frame_count  uint16 scale
+#   int16 x, y, z per vertex per frame (projected, relative to the centre)
+
+import math
+import struct
+import argparse
+import obj2mesh
+
+DEFAULT_FRAMES = 4096
+DEFAULT_SCALE = 96
+TRIG_ONE = 4096
+
+# The built-in cube of src/main.c
+CUBE = [
+    (-4096, -4096, -4096), (4096, -4096, -4096), (4096, 4096, -4096), (-4096, 4096, -4096),
+    (-4096, -4096, 4096), (4096, -4096, 4096), (4096, 4096, 4096), (-4096, 4096, 4096),
+]
+
+
+def isin(angle: int):
+    """Same values as the quarter-wave table of src/trig.c."""
+    return round(math.sin((angle & 255) * math.pi / 128) * TRIG_ONE)
+
+
+def icos(angle: int):
+    return isin(angle + 64)
+
+
+def div(a: int, b: int):
+    """C division, truncating towards zero."""
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b > 0) else -q
+
+
+def project(vertices, ax: int, ay: int, az: int, scale: int):
+    """Rotate and project like projectMesh() in src/main.c."""
+    sx, cx = isin(ax), icos(ax)
+    sy, cy = isin(ay), icos(ay)
+    sz, cz = isin(az), icos(az)
+    out = []
+    for x, y, z in vertices:
+        rx = (x * cy + z * sy) >> 12
+        rz = (z * cy - x * sy) >> 12
+        ry = (y * cx - rz * sx) >> 12
+        rz = (y * sx + rz * cx) >> 12
+        px = (rx * cz - ry * sz) >> 12
+        py = (rx * sz + ry * cz) >> 12
+        out.append((div(px, scale), div(py, scale), div(rz, scale)))
+    return out
+
+
+def exec_args():
+    parser = argparse.ArgumentParser(
+        description="Bake a tumbling animation of the cube or an OBJ model into a pose stream."
+    )
+    parser.add_argument("filename", nargs="?", help="OBJ file. Default is the built-in cube.")
+    parser.add_argument("-o", dest="out", metavar="name", required=True, help="Output pose stream.")
+    parser.add_argument(
+        "-n",
+        "--frames",
+        dest="frames",
+        type=int,
+        default=DEFAULT_FRAMES,
+        help=f"Number of poses. Default={DEFAULT_FRAMES}",
+    )
+    parser.add_argument(
+        "-s",
+        "--scale",
+        dest="scale",
+        type=int,
+        default=DEFAULT_SCALE,
+        help=f"SCALE of the screen mode the stream is for. Default={DEFAULT_SCALE}",
+    )
+    args = parser.parse_args()
+    if args.frames < 1 or args.frames > 0xFFFF:
+        parser.error("argument -n/--frames: 1 to 65535 poses")
+
+    if args.filename:
+        mesh = obj2mesh.Mesh()
+        mesh.load_obj(args.filename)
+        vertices = mesh.scaled_vertices(obj2mesh.DEFAULT_RADIUS)
+    else:
+        vertices = CUBE
+
+    data = bytearray(b"PS")
+    data += struct.pack("<BBHH", len(vertices), 0, args.frames, args.scale)
+    for i in range(args.frames):
+        # three incommensurate spins in 1/4 angle units, so the tumble
+        # does not repeat within the stream
+        pose = project(vertices, (i * 7) >> 2, (i * 5) >> 2, (i * 3) >> 2, args.scale)
+        for v in pose:
+            data += struct.pack("<hhh", *v)
+    with open(args.out, "wb") as file:
+        file.write(data)
+    print(
+        f"[bake_poses.py] {args.out}: {args.frames} poses of {len(vertices)} vertices, "
+        f"{len(data)} bytes"
+    )
+
+
+if __name__ == "__main__":
+    exec_args()
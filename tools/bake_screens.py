@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: Unlicense
+
+# Render the fixed text of the title and pause screens with the font of
+# src/font5x7.h into 1bpp bitmaps, so src/main.c can blit them instead of
+# drawing them pixel by pixel.
+#
+# Screen pack layout (little-endian):
+#
+#   'S' 'P' count 0  uint16 offset[count]   (from pack start)
+#   image:  uint8 width_bytes  uint8 height  uint8 left  uint8 bpp
+#           uint8 rows[height][width_bytes]  (leftmost pixel in bit 7)
+#
+# The text of an image starts left pixels into its first byte: blitting it
+# at x - left, with x the byte-aligned position, puts the text where
+# draw_string2buffer would have put it at x.
+
+import re
+import struct
+import argparse
+import os
+
+DEFAULT_FONT = os.path.join(os.path.dirname(__file__), "..", "src", "font5x7.h")
+DEFAULT_X = 10
+
+# In pack order, the SCREEN_* indices of src/main.c; the help lines are the
+# help[] and help_more[] columns of drawHelp() there. The second column is
+# blitted 160 pixels right of the first, which keeps x % 8 and so the left
+# offset these images are rendered with.
+# Each line is (text, dy, text multiplier).
+SCREENS = [
+    ("title", [("3D cube", 0, 4)]),
+    (
+        "help",
+        [
+            ("[SPACE] start/stop", 0, 1),
+            ("[M] drawing mode", 10, 1),
+            ("[N] next mesh", 20, 1),
+            ("[+/-] more/fewer objects", 30, 1),
+            ("[UP/DOWN] nearer/farther", 40, 1),
+            ("[B] buffer indicator", 50, 1),
+            ("[C] vertex coordinates", 60, 1),
+            ("[ESC] exit", 70, 1),
+        ],
+    ),
+    (
+        "help_more",
+        [
+            ("[P] pose stream (USB)", 0, 1),
+            ("[I] interpolate poses", 10, 1),
+            ("[G] governor, low res", 20, 1),
+            ("[W] draw in a window", 30, 1),
+            ("[R] band rendering", 40, 1),
+            ("[S] stats on console", 50, 1),
+        ],
+    ),
+    ("start", [("PRESS ANY KEY TO START", 0, 1)]),
+    ("continue", [("Press SPACE to continue", 0, 1)]),
+]
+
+
+def load_font(filename: str):
+    """The columns of the glyphs, 5 bytes each, bit 0 at the top."""
+    with open(filename) as file:
+        text = file.read()
+    body = text[text.index("font[]") :]
+    body = body[body.index("{") + 1 : body.index("}")]
+    columns = [int(v, 16) for v in re.findall(r"0x([0-9A-Fa-f]{2})", body)]
+    if len(columns) < 128 * 5:
+        raise ValueError(f"{filename}: {len(columns)} font bytes, too few for ASCII")
+    return columns
+
+
+def render(font, lines, left: int):
+    """Draw like draw_char2buffer() with a transparent background.
+    Returns the set pixels as a set of (x, y)."""
+    pixels = set()
+    for text, dy, mult in lines:
+        x = left
+        for chr in text.encode("ascii"):
+            for i in range(5):
+                column = font[chr * 5 + i]
+                for j in range(8):
+                    if column & (1 << j):
+                        for py in range(mult):
+                            for px in range(mult):
+                                pixels.add((x + i * mult + px, dy + j * mult + py))
+            x += 6 * mult
+    return pixels
+
+
+def pack_image(pixels, left: int):
+    width = max(x for x, _ in pixels) + 1
+    height = max(y for _, y in pixels) + 1
+    width_bytes = (width + 7) // 8
+    if width_bytes > 255 or height > 255:
+        raise ValueError("image too large")
+    data = bytearray(struct.pack("<BBBB", width_bytes, height, left, 1))
+    for y in range(height):
+        for b in range(width_bytes):
+            byte = 0
+            for bit in range(8):
+                if (b * 8 + bit, y) in pixels:
+                    byte |= 0x80 >> bit
+            data.append(byte)
+    return data
+
+
+def exec_args():
+    parser = argparse.ArgumentParser(
+        description="Render the title and help screen text into an RP6502 screen pack."
+    )
+    parser.add_argument("-o", dest="out", metavar="name", required=True, help="Output screen pack.")
+    parser.add_argument(
+        "-f",
+        "--font",
+        dest="font",
+        default=DEFAULT_FONT,
+        help="Font header. Default=src/font5x7.h",
+    )
+    parser.add_argument(
+        "-x",
+        dest="x",
+        type=int,
+        default=DEFAULT_X,
+        help=f"Screen column the text starts at. Default={DEFAULT_X}",
+    )
+    args = parser.parse_args()
+
+    font = load_font(args.font)
+    left = args.x % 8
+    images = []
+    for name, lines in SCREENS:
+        image = pack_image(render(font, lines, left), left)
+        print(f"[bake_screens.py] {name}: {image[0] * 8}x{image[1]} pixels, {len(image)} bytes")
+        images.append(image)
+
+    pack = bytearray(b"SP")
+    pack += struct.pack("<BB", len(images), 0)
+    offset = 4 + 2 * len(images)
+    for image in images:
+        pack += struct.pack("<H", offset)
+        offset += len(image)
+    for image in images:
+        pack += image
+    with open(args.out, "wb") as file:
+        file.write(pack)
+    print(f"[bake_screens.py] {args.out}: {len(pack)} bytes")
+
+
+if __name__ == "__main__":
+    exec_args()
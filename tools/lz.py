@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: Unlicense
+
+# LZ compression for ROM assets, unpacked on the RP6502 by src/lz.c
+#
+# Layout (little-endian):
+#
+#   'L' 'Z' uint16 unpacked_length
+#   tokens, until unpacked_length bytes are produced:
+#     0nnnnnnn                  n+1 literal bytes follow
+#     1nnnnnnn  uint16 offset   copy n+3 bytes from offset bytes back
+#                               (may overlap the bytes being produced)
+
+import struct
+import argparse
+
+MIN_MATCH = 3
+MAX_MATCH = 0x7F + MIN_MATCH
+MAX_LITERALS = 0x80
+MAX_OFFSET = 0xFFFF
+MAX_CHAIN = 256  # match candidates tried per position
+
+
+def compress(data: bytes):
+    """Greedy LZ77 with hash chains over 3-byte prefixes."""
+    out = bytearray(b"LZ")
+    out += struct.pack("<H", len(data))
+    literals = bytearray()
+    chains = {}
+
+    def flush_literals():
+        nonlocal literals
+        while literals:
+            run = literals[:MAX_LITERALS]
+            out.append(len(run) - 1)
+            out.extend(run)
+            literals = literals[len(run) :]
+
+    def remember(i):
+        if i + MIN_MATCH <= len(data):
+            chains.setdefault(bytes(data[i : i + MIN_MATCH]), []).append(i)
+
+    i = 0
+    while i < len(data):
+        best_length = best_offset = 0
+        candidates = chains.get(bytes(data[i : i + MIN_MATCH]), [])
+        for j in reversed(candidates[-MAX_CHAIN:]):
+            if i - j > MAX_OFFSET:
+                break
+            length = 0
+            while (
+                length < MAX_MATCH
+                and i + length < len(data)
+                and data[j + length] == data[i + length]
+            ):
+                length += 1
+            if length > best_length:
+                best_length, best_offset = length, i - j
+                if length == MAX_MATCH:
+                    break
+        if best_length >= MIN_MATCH:
+            flush_literals()
+            out.append(0x80 | (best_length - MIN_MATCH))
+            out += struct.pack("<H", best_offset)
+            for k in range(best_length):
+                remember(i + k)
+            i += best_length
+        else:
+            literals.append(data[i])
+            remember(i)
+            i += 1
+    flush_literals()
+    return bytes(out)
+
+
+def decompress(packed: bytes):
+    """Reference unpacker, the same steps as src/lz.c."""
+    if packed[0:2] != b"LZ":
+        raise RuntimeError("Not LZ data")
+    (length,) = struct.unpack("<H", packed[2:4])
+    out = bytearray()
+    i = 4
+    while len(out) < length:
+        token = packed[i]
+        i += 1
+        if token & 0x80:
+            (offset,) = struct.unpack("<H", packed[i : i + 2])
+            i += 2
+            for k in range((token & 0x7F) + MIN_MATCH):
+                out.append(out[-offset])
+        else:
+            out += packed[i : i + token + 1]
+            i += token + 1
+    return bytes(out)
+
+
+def exec_args():
+    parser = argparse.ArgumentParser(description="LZ-compress a file for unpacking on the RP6502.")
+    parser.add_argument("filename", help="File to compress.")
+    parser.add_argument("-o", dest="out", metavar="name", required=True, help="Compressed output.")
+    args = parser.parse_args()
+
+    with open(args.filename, "rb") as f:
+        data = f.read()
+    if len(data) > 0xFFFF:
+        raise RuntimeError(f"{args.filename}: more than 64K")
+    packed = compress(data)
+    if decompress(packed) != data:
+        raise RuntimeError(f"{args.filename}: compression does not round-trip")
+    with open(args.out, "wb") as f:
+        f.write(packed)
+    print(
+        f"[lz.py] {args.filename}: {len(data)} -> {len(packed)} bytes "
+        f"({100 * len(packed) / max(len(data), 1):.0f}%)"
+    )
+
+
+if __name__ == "__main__":
+    exec_args()
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: Unlicense
+
+# Convert Wavefront OBJ models into the mesh pack format read by src/mesh.c
+
+import math
+import struct
+import argparse
+
+# Bounding radius of the built-in cube (corners at +-4096 on every axis)
+DEFAULT_RADIUS = 7094
+MAX_VERTICES = 128
+
+
+class Mesh:
+    """One model: vertices, deduplicated edges and optional faces."""
+
+    def __init__(self):
+        self.vertices = []
+        self.edges = []
+        self.faces = []
+        self.edge_set = set()
+
+    def add_edge(self, a: int, b: int):
+        """Add edge a-b unless it (or b-a) is already present."""
+        if a == b:
+            return
+        key = (min(a, b), max(a, b))
+        if key not in self.edge_set:
+            self.edge_set.add(key)
+            self.edges.append((a, b))
+
+    def load_obj(self, file):
+        """Read the v, f and l statements of an OBJ file."""
+
+        def index(token):
+            """OBJ indices are 1-based, negative ones count from the end."""
+            i = int(token.split("/")[0])
+            if i < 0:
+                i += len(self.vertices)
+            else:
+                i -= 1
+            if i < 0 or i >= len(self.vertices):
+                raise RuntimeError(f"{file}: vertex index {token} out of range")
+            return i
+
+        with open(file, "r") as f:
+            for line in f:
+                fields = line.split("#")[0].split()
+                if len(fields) == 0:
+                    continue
+                if fields[0] == "v":
+                    self.vertices.append(tuple(float(c) for c in fields[1:4]))
+                elif fields[0] == "f":
+                    face = [index(t) for t in fields[1:]]
+                    if len(face) < 3:
+                        raise RuntimeError(f"{file}: face with fewer than 3 vertices")
+                    self.faces.append(face)
+                    for i in range(len(face)):
+                        self.add_edge(face[i], face[(i + 1) % len(face)])
+                elif fields[0] == "l":
+                    line_indices = [index(t) for t in fields[1:]]
+                    for i in range(len(line_indices) - 1):
+                        self.add_edge(line_indices[i], line_indices[i + 1])
+        if len(self.vertices) > MAX_VERTICES:
+            raise RuntimeError(f"{file}: more than {MAX_VERTICES} vertices")
+        if len(self.edges) == 0:
+            raise RuntimeError(f"{file}: no edges")
+
+    def scaled_vertices(self, radius: int):
+        """Integer vertices about the centroid, within radius, y down."""
+        n = len(self.vertices)
+        cx = sum(v[0] for v in self.vertices) / n
+        cy = sum(v[1] for v in self.vertices) / n
+        cz = sum(v[2] for v in self.vertices) / n
+        extent = max(
+            math.sqrt((v[0] - cx) ** 2 + (v[1] - cy) ** 2 + (v[2] - cz) ** 2)
+            for v in self.vertices
+        )
+        scale = radius / extent if extent > 0 else 0
+        # OBJ is y-up, the screen is y-down
+        return [
+            (
+                round((v[0] - cx) * scale),
+                round(-(v[1] - cy) * scale),
+                round((v[2] - cz) * scale),
+            )
+            for v in self.vertices
+        ]
+
+    def to_bytes(self, radius: int, faces: bool):
+        """Scale about the centroid to radius and encode as a mesh record."""
+        n = len(self.vertices)
+        face_data = bytearray()
+        if faces:
+            for face in self.faces:
+                face_data.append(len(face))
+                face_data.extend(face)
+        data = bytearray(b"M3")
+        data += struct.pack(
+            "<BBHHHH",
+            n,
+            1 if faces and len(self.faces) else 0,
+            len(self.edges),
+            len(self.faces) if faces else 0,
+            len(face_data),
+            radius,
+        )
+        for v in self.scaled_vertices(radius):
+            data += struct.pack("<hhh", *v)
+        for a, b in self.edges:
+            data += struct.pack("<BB", a, b)
+        data += face_data
+        return data
+
+
+def exec_args():
+    parser = argparse.ArgumentParser(
+        description="Convert Wavefront OBJ files (v, f and l statements) into an RP6502 mesh pack."
+    )
+    parser.add_argument("filename", nargs="+", help="OBJ file(s), in pack order.")
+    parser.add_argument("-o", dest="out", metavar="name", required=True, help="Output mesh pack.")
+    parser.add_argument(
+        "-r",
+        "--radius",
+        dest="radius",
+        type=int,
+        default=DEFAULT_RADIUS,
+        help=f"Bounding radius in vertex units. Default={DEFAULT_RADIUS}",
+    )
+    parser.add_argument(
+        "--no-faces", dest="faces", action="store_false", help="Leave out the face lists."
+    )
+    args = parser.parse_args()
+
+    records = []
+    for file in args.filename:
+        mesh = Mesh()
+        mesh.load_obj(file)
+        record = mesh.to_bytes(args.radius, args.faces)
+        print(
+            f"[obj2mesh.py] {file}: {len(mesh.vertices)} vertices, "
+            f"{len(mesh.edges)} edges, {len(mesh.faces)} faces, {len(record)} bytes"
+        )
+        records.append(record)
+
+    pack = bytearray(b"MP")
+    pack += struct.pack("<BB", len(records), 0)
+    offset = 4 + 2 * len(records)
+    for record in records:
+        pack += struct.pack("<H", offset)
+        offset += len(record)
+    for record in records:
+        pack += record
+    with open(args.out, "wb") as file:
+        file.write(pack)
+
+
+if __name__ == "__main__":
+    exec_args()
@@ -1,400 +1,734 @@
-#!/usr/bin/env python3
-#
-# Copyright (c) 2023 Rumbledethumps
-#
-# SPDX-License-Identifier: BSD-3-Clause
-# SPDX-License-Identifier: Unlicense
-
-# Control RP6502 RIA via UART
-
-import os
-import re
-import time
-import serial
-import binascii
-import argparse
-import configparser
-import platform
-from typing import Union
-
-
-class Monitor:
-    """Manages the monitor application on the serial console."""
-
-    DEFAULT_TIMEOUT = 0.5
-    UART_BAUDRATE = 115200
-
-    def __init__(self, name, timeout=DEFAULT_TIMEOUT):
-        self.serial = serial.Serial()
-        self.serial.setPort(name)
-        self.serial.timeout = timeout
-        self.serial.baudrate = self.UART_BAUDRATE
-        self.serial.open()
-
-    def send_break(self, duration=0.01, retries=1):
-        """Stop the 6502 and return to monitor."""
-        self.serial.read_all()
-        if platform.system() == "Darwin":
-            self.serial.baudrate = 1200
-            self.serial.write(b"\0")
-            self.serial.baudrate = self.UART_BAUDRATE
-        else:
-            self.serial.send_break(duration)
-        try:
-            self.wait_for_prompt("]")
-            return
-        except TimeoutError as te:
-            if retries <= 0:
-                raise te
-        self.send_break(duration, retries - 1)
-
-    def command(self, str, timeout=DEFAULT_TIMEOUT):
-        """Send one command and wait for next monitor prompt"""
-        self.serial.write(bytes(str, "ascii"))
-        self.serial.write(b"\r")
-        self.wait_for_prompt("]", timeout)
-
-    def reset(self):
-        """Start the 6502."""
-        self.serial.write(b"RESET\r")
-        self.serial.read_until()
-
-    def binary(self, addr: int, data):
-        """Send data to memory using BINARY command."""
-        command = f"BINARY ${addr:04X} ${len(data):03X} ${binascii.crc32(data):08X}\r"
-        self.serial.write(bytes(command, "utf-8"))
-        self.serial.write(data)
-        self.wait_for_prompt("]")
-
-    def upload(self, file, name):
-        """Upload readable file to remote file "name" """
-        self.serial.write(bytes(f"UPLOAD {name}\r", "ascii"))
-        self.wait_for_prompt("}")
-        file.seek(0)
-        while True:
-            chunk = file.read(1024)
-            if len(chunk) == 0:
-                break
-            command = f"${len(chunk):03X} ${binascii.crc32(chunk):08X}\r"
-            self.serial.write(bytes(command, "ascii"))
-            self.serial.write(chunk)
-            self.wait_for_prompt("}")
-        self.serial.write(b"END\r")
-        self.wait_for_prompt("]")
-
-    def send_rom(self, rom):
-        """Send rom."""
-        addr, data = rom.next_rom_data(0)
-        while data != None:
-            self.binary(addr, data)
-            addr += len(data)
-            addr, data = rom.next_rom_data(addr)
-
-    def wait_for_prompt(self, prompt, timeout=DEFAULT_TIMEOUT):
-        """Wait for prompt."""
-        prompt = bytes(prompt, "ascii")
-        start = time.monotonic()
-        while True:
-            if len(prompt) == 1:
-                data = self.serial.read()
-            else:
-                data = self.serial.read_until()
-            if data[0:1] == b"?":
-                monitor_result = data.decode("ascii")
-                monitor_result += self.serial.read_until().decode("ascii").strip()
-                raise RuntimeError(monitor_result)
-            if data == prompt:
-                break
-            if len(data) == 0:
-                if time.monotonic() - start > timeout:
-                    raise TimeoutError()
-
-
-class ROM:
-    """Virtual ROM aka The RP6502 ROM."""
-
-    def __init__(self):
-        """ROMs begin with up to a screen of help text"""
-        """ followed by a sparse array of virtual ROM. """
-        self.help = []
-        self.data = [0 for i in range(0x20000)]
-        self.alloc = [0 for i in range(0x20000)]
-
-    def add_help(self, string):
-        """Add help string."""
-        if len(string) > 80:
-            raise RuntimeError("Help line too long")
-        self.help.append(string)
-        if len(self.help) > 24:
-            raise RuntimeError("Help lines > 24")
-
-    def add_binary_data(self, data, addr: int):
-        """Add binary data."""
-        offset = 0
-        length = len(data)
-        self.allocate_rom(addr, length)
-        for i in range(length):
-            self.data[addr + i] = data[offset + i]
-
-    def add_irq_vector(self, addr: int):
-        """Set IRQ vector in $FFFE and $FFFF."""
-        if addr < 0 or addr > 0xFFFF:
-            raise RuntimeError(f"Invalid IRQ vector: ${addr:04X}")
-        self.allocate_rom(0xFFFE, 2)
-        self.data[0xFFFE] = addr & 0xFF
-        self.data[0xFFFF] = addr >> 8
-
-    def add_nmi_vector(self, addr: int):
-        """Set NMI vector in $FFFA and $FFFB."""
-        if addr < 0 or addr > 0xFFFF:
-            raise RuntimeError(f"Invalid NMI vector: ${addr:04X}")
-        self.allocate_rom(0xFFFA, 2)
-        self.data[0xFFFA] = addr & 0xFF
-        self.data[0xFFFB] = addr >> 8
-
-    def add_reset_vector(self, addr: int):
-        """Set reset vector in $FFFC and $FFFD."""
-        if addr < 0 or addr > 0xFFFF:
-            raise RuntimeError(f"Invalid reset vector: ${addr:04X}")
-        self.allocate_rom(0xFFFC, 2)
-        self.data[0xFFFC] = addr & 0xFF
-        self.data[0xFFFD] = addr >> 8
-
-    def add_binary_file(self, file, addr: Union[int, None] = None):
-        """Add binary memory data from file. addr=None uses"""
-        """first two bytes as address and second two bytes as reset."""
-        with open(file, "rb") as f:
-            data = f.read()
-        if addr == None:
-            if len(data) < 4:
-                raise RuntimeError("No addresses found.")
-            addr = data[0] + data[1] * 256
-            self.add_reset_vector(data[2] + data[3] * 256)
-            data = data[4:]
-        self.add_binary_data(data, addr)
-
-    def add_rp6502_file(self, file):
-        """Add RP6502 ROM data from file."""
-        with open(file, "rb") as f:
-            # Decode first line as cp850 because binary garbage can
-            # raise here before our better message gets to the user.
-            command = f.readline().decode("cp850")
-            if not re.match("^#![Rr][Pp]6502(\r|)\n$", command):
-                raise RuntimeError(f"Invalid RP6502 ROM file: {file}")
-            while True:
-                command = f.readline().decode("ascii").rstrip()
-                if len(command) == 0:
-                    break
-                se = re.search("^ *(# )", command)
-                if se:
-                    self.add_help(command[se.start(1) + 2 :])
-                    continue
-                if re.search("^ *#$", command):
-                    self.add_help("")
-                    continue
-                se = re.search("^ *([^ ]+) *([^ ]+) *([^ ]+) *$", command)
-                if se:
-
-                    def str_to_address(str):
-                        """Supports $FFFF number format."""
-                        if str:
-                            str = re.sub("^\\$", "0x", str)
-                        if re.match("^(0x|)[0-9A-Fa-f]*$", str):
-                            return eval(str)
-                        else:
-                            raise RuntimeError(f"Invalid address: {str}")
-
-                    addr = str_to_address(se.group(1))
-                    length = str_to_address(se.group(2))
-                    crc = str_to_address(se.group(3))
-                    self.allocate_rom(addr, length)
-                    data = f.read(length)
-                    if len(data) != length or crc != binascii.crc32(data):
-                        raise RuntimeError(f"Invalid CRC in block address: ${addr:04X}")
-                    for i in range(length):
-                        self.data[addr + i] = data[i]
-                    continue
-                raise RuntimeError(f"Corrupt RP6502 ROM file: {file}")
-
-    def allocate_rom(self, addr, length):
-        """Marks a range of memory as used. Raises on error."""
-        if (
-            (addr < 0x10000 and addr + length > 0x10000)
-            or addr + length > 0x20000
-            or addr < 0
-            or length < 0
-        ):
-            raise IndexError(
-                f"RP6502 invalid address ${addr+i:04X} or length ${length+i:03X}"
-            )
-        for i in range(length):
-            if self.alloc[addr + i]:
-                raise MemoryError(f"RP6502 ROM data already exists at ${addr+i:04X}")
-            self.alloc[addr + i] = 1
-
-    def has_reset_vector(self):
-        """Returns true if $FFFC and $FFFD have been set."""
-        return self.alloc[0xFFFC] and self.alloc[0xFFFD]
-
-    def next_rom_data(self, addr: int):
-        """Find next up-to-1k chunk starting at addr."""
-        for addr in range(addr, 0x20000):
-            if self.alloc[addr]:
-                length = 0
-                while self.alloc[addr + length]:
-                    length += 1
-                    if length == 1024 or addr + length == 0x10000:
-                        break
-                return addr, bytearray(self.data[addr : addr + length])
-        return None, None
-
-
-def exec_args():
-    # Give a hint at where the USB CDC mounts on various OSs
-    if platform.system() == "Windows":
-        default_device = "COM1"
-    elif platform.system() == "Darwin":
-        default_device = "/dev/tty.usbmodem"
-    elif platform.system() == "Linux":
-        default_device = "/dev/ttyACM0"
-    else:
-        default_device = "/dev/tty"
-
-    # Standard library argument parser
-    parser = argparse.ArgumentParser(
-        description="Interface with RP6502 RIA console via UART. Manage RP6502 ROM asset packaging."
-    )
-    parser.add_argument(
-        "command",
-        choices=["run", "upload", "create"],
-        help="Run local RP6502 ROM file by sending to RP6502 RAM. "
-        "Upload any local files to RP6502 USB MSC drive. "
-        "Create RP6502 ROM file from a local binary file and additional local ROM files. ",
-    )
-    parser.add_argument("filename", nargs="*", help="Local filename(s).")
-    parser.add_argument("-o", dest="out", metavar="name", help="Output path/filename.")
-    parser.add_argument(
-        "-c",
-        "--config",
-        dest="config",
-        metavar="name",
-        help=f"Configuration file for serial device.",
-    )
-    parser.add_argument(
-        "-D",
-        "--device",
-        dest="device",
-        metavar="dev",
-        default=default_device,
-        help=f"Serial device name. Default={default_device}",
-    )
-    parser.add_argument(
-        "-a",
-        "--address",
-        dest="address",
-        metavar="addr",
-        help="Starting address of file. If not provided, "
-        "the first two bytes of the file are the start address and "
-        "the second two bytes of the file are the reset vector.",
-    )
-    parser.add_argument("-i", "--irq", dest="irq", metavar="addr", help="IRQ vector.")
-    parser.add_argument("-n", "--nmi", dest="nmi", metavar="addr", help="NMI vector.")
-    parser.add_argument(
-        "-r", "--reset", dest="reset", metavar="addr", help="Reset vector."
-    )
-    args = parser.parse_args()
-
-    # Standard library configuration parser
-    if args.config:
-        config = configparser.ConfigParser()
-        if not os.path.exists(args.config):
-            config["RP6502"] = {"device": args.device}
-            config.write(open(args.config, "w"))
-        else:
-            config.read(args.config)
-        if config.has_section("RP6502"):
-            args.device = config["RP6502"].get("device", args.device)
-
-    # Additional validation and conversion
-    def str_to_address(parser, str, errmsg):
-        """Supports $FFFF number format."""
-        if str:
-            str = re.sub("^\\$", "0x", str)
-            if re.match("^(0x|)[0-9A-Fa-f]*$", str):
-                return eval(str)
-            else:
-                parser.error(f"argument {errmsg}: invalid address: '{str}'")
-
-    args.address = str_to_address(parser, args.address, "-a/--address")
-    args.irq = str_to_address(parser, args.irq, "-i/--irq")
-    args.nmi = str_to_address(parser, args.nmi, "-n/--nmi")
-    args.reset = str_to_address(parser, args.reset, "-r/--reset")
-
-    # python3 tools/rp6502.py run
-    if args.command == "run":
-        print(f"[{os.path.basename(__file__)}] Loading ROM {args.filename[0]}")
-        rom = ROM()
-        rom.add_rp6502_file(args.filename[0])
-        if args.reset != None:
-            rom.add_reset_vector(args.reset)
-        print(f"[{os.path.basename(__file__)}] Opening device {args.device}")
-        mon = Monitor(args.device)
-        mon.send_break()
-        mon.send_rom(rom)
-        if rom.has_reset_vector():
-            mon.reset()
-        else:
-            print("No reset vector. Not resetting.")
-
-    # python3 tools/rp6502.py upload
-    if args.command == "upload":
-        print(f"[{os.path.basename(__file__)}] Opening device {args.device}")
-        mon = Monitor(args.device)
-        if len(args.filename) > 0:
-            mon.send_break()
-        for file in args.filename:
-            print(f"[{os.path.basename(__file__)}] Uploading {file}")
-            with open(file, "rb") as f:
-                if len(args.filename) == 1 and args.out != None:
-                    dest = args.out
-                else:
-                    dest = os.path.basename(file)
-                mon.upload(f, dest)
-
-    # python3 tools/rp6502.py create
-    if args.command == "create":
-        print(f"[{os.path.basename(__file__)}] Creating {args.out}")
-        rom = ROM()
-        if args.irq != None:
-            rom.add_irq_vector(args.irq)
-        if args.nmi != None:
-            rom.add_nmi_vector(args.nmi)
-        if args.reset != None:
-            rom.add_reset_vector(args.reset)
-        print(f"[{os.path.basename(__file__)}] Adding Binary Asset {args.filename[0]}")
-        rom.add_binary_file(args.filename[0], args.address)
-        for file in args.filename[1:]:
-            print(f"[{os.path.basename(__file__)}] Adding ROM Asset {file}")
-            rom.add_rp6502_file(file)
-        with open(args.out, "wb+") as file:
-            file.write(b"#!RP6502\n")
-            for help in rom.help:
-                file.write(bytes(f"# {help}\n", "ascii"))
-            addr, data = rom.next_rom_data(0)
-            while data != None:
-                file.write(
-                    bytes(
-                        f"${addr:04X} ${len(data):03X} ${binascii.crc32(data):08X}\n",
-                        "ascii",
-                    )
-                )
-                file.write(data)
-                addr += len(data)
-                addr, data = rom.next_rom_data(addr)
-
-
-# This file may be included or run like a program. e.g.
-#   import importlib
-#   rp6502 = importlib.import_module("tools.rp6502")
-if __name__ == "__main__":
-    exec_args()
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023 Rumbledethumps
+#
+# SPDX-License-Identifier: BSD-3-Clause
+# SPDX-License-Identifier: Unlicense
+
+# Control RP6502 RIA via UART
+
+import os
+import re
+import json
+import time
+import serial
+import binascii
+import argparse
+import collections
+import configparser
+import platform
+from typing import Union
+
+
+class Monitor:
+    """Manages the monitor application on the serial console."""
+
+    DEFAULT_TIMEOUT = 0.5
+    UART_BAUDRATE = 115200
+
+    def __init__(self, name, timeout=DEFAULT_TIMEOUT):
+        self.serial = serial.Serial()
+        self.serial.setPort(name)
+        self.serial.timeout = timeout
+        self.serial.baudrate = self.UART_BAUDRATE
+        self.serial.open()
+
+    def send_break(self, duration=0.01, retries=1):
+        """Stop the 6502 and return to monitor."""
+        self.serial.read_all()
+        if platform.system() == "Darwin":
+            self.serial.baudrate = 1200
+            self.serial.write(b"\0")
+            self.serial.baudrate = self.UART_BAUDRATE
+        else:
+            self.serial.send_break(duration)
+        try:
+            self.wait_for_prompt("]")
+            return
+        except TimeoutError as te:
+            if retries <= 0:
+                raise te
+        self.send_break(duration, retries - 1)
+
+    def command(self, str, timeout=DEFAULT_TIMEOUT):
+        """Send one command and wait for next monitor prompt"""
+        self.serial.write(bytes(str, "ascii"))
+        self.serial.write(b"\r")
+        self.wait_for_prompt("]", timeout)
+
+    def reset(self):
+        """Start the 6502."""
+        self.serial.write(b"RESET\r")
+        self.serial.read_until()
+
+    def binary(self, addr: int, data):
+        """Send data to memory using BINARY command."""
+        self.send_binary(addr, data)
+        self.wait_for_prompt("]")
+
+    def send_binary(self, addr: int, data):
+        """Send a BINARY command without waiting for its prompt."""
+        command = f"BINARY ${addr:04X} ${len(data):03X} ${binascii.crc32(data):08X}\r"
+        self.serial.write(bytes(command, "utf-8"))
+        self.serial.write(data)
+
+    def binary_window(self, chunks, window=1, retries=3):
+        """Send a list of (addr, data) with BINARY, keeping up to window
+        commands in flight. Prompts come back in command order. After
+        an error nothing more is queued: the monitor is left to finish
+        the commands in flight, and whatever it made of the data of one
+        it rejected, then everything from the failed command on is sent
+        again one command at a time."""
+        pending = collections.deque()
+        failures = collections.Counter()
+        to_send = 0
+        while to_send < len(chunks) or pending:
+            while to_send < len(chunks) and len(pending) < window:
+                self.send_binary(*chunks[to_send])
+                pending.append(to_send)
+                to_send += 1
+            try:
+                self.wait_for_prompt("]")
+                pending.popleft()
+            except (RuntimeError, TimeoutError) as e:
+                failed = pending.popleft()
+                failures[failed] += 1
+                if failures[failed] > retries:
+                    raise e
+                addr, data = chunks[failed]
+                print(f"Retrying ${addr:04X} after: {e or 'timeout'}")
+                self.resync()
+                pending.clear()
+                to_send = failed
+                window = 1
+
+    def resync(self, timeout=DEFAULT_TIMEOUT, attempts=10):
+        """Discard the replies of commands in flight until the monitor
+        has been quiet for timeout, then get a clean prompt."""
+        for _ in range(attempts):
+            time.sleep(timeout)
+            if self.serial.read_all():
+                continue
+            self.serial.write(b"\r")
+            try:
+                self.wait_for_prompt("]", timeout)
+                return
+            except (RuntimeError, TimeoutError):
+                pass
+        raise TimeoutError("monitor does not settle")
+
+    def upload(self, file, name):
+        """Upload readable file to remote file "name" """
+        self.serial.write(bytes(f"UPLOAD {name}\r", "ascii"))
+        self.wait_for_prompt("}")
+        file.seek(0)
+        while True:
+            chunk = file.read(1024)
+            if len(chunk) == 0:
+                break
+            command = f"${len(chunk):03X} ${binascii.crc32(chunk):08X}\r"
+            self.serial.write(bytes(command, "ascii"))
+            self.serial.write(chunk)
+            self.wait_for_prompt("}")
+        self.serial.write(b"END\r")
+        self.wait_for_prompt("]")
+
+    def send_rom(self, rom, manifest=None, read_only=(), window=1):
+        """Send rom. Chunks that lie in one of the read_only (first, last)
+        address ranges and that the manifest says were sent unchanged
+        last time are skipped. Only memory the program never writes,
+        such as XRAM assets, can be trusted to still hold them.
+        Returns bytes (sent, skipped)."""
+        chunks = []
+        sent = skipped = 0
+        if manifest != None:
+            # An interrupted upload leaves the device in an unknown state
+            manifest.forget()
+        addr, data = rom.next_rom_data(0)
+        while data != None:
+            kept = any(first <= addr and addr + len(data) - 1 <= last for first, last in read_only)
+            if kept and manifest != None and manifest.has_chunk(addr, data):
+                skipped += len(data)
+            else:
+                chunks.append((addr, data))
+                sent += len(data)
+            if manifest != None:
+                manifest.add_chunk(addr, data)
+            addr += len(data)
+            addr, data = rom.next_rom_data(addr)
+        self.binary_window(chunks, window)
+        return sent, skipped
+
+    def wait_for_prompt(self, prompt, timeout=DEFAULT_TIMEOUT):
+        """Wait for prompt."""
+        prompt = bytes(prompt, "ascii")
+        start = time.monotonic()
+        while True:
+            if len(prompt) == 1:
+                data = self.serial.read()
+            else:
+                data = self.serial.read_until()
+            if data[0:1] == b"?":
+                monitor_result = data.decode("ascii")
+                monitor_result += self.serial.read_until().decode("ascii").strip()
+                raise RuntimeError(monitor_result)
+            if data == prompt:
+                break
+            if len(data) == 0:
+                if time.monotonic() - start > timeout:
+                    raise TimeoutError()
+
+
+class Manifest:
+    """What was last sent to each device: a CRC of every ROM chunk
+    written to memory and of every file uploaded to the USB drive.
+    The device is not asked, so this only holds while nothing else
+    changed its memory or files. Running programs write to their own
+    initialized data, so only chunks of read-only ranges are skipped;
+    a power cycle needs a full upload."""
+
+    def __init__(self, path, device):
+        self.path = path
+        self.device = device
+        self.all = {}
+        if os.path.exists(path):
+            try:
+                with open(path, "r") as f:
+                    self.all = json.load(f)
+            except (OSError, ValueError):
+                self.all = {}
+        self.entry = self.all.setdefault(device, {})
+        self.entry.setdefault("chunks", {})
+        self.entry.setdefault("files", {})
+        self.previous = self.entry["chunks"]
+
+    def save(self):
+        with open(self.path, "w") as f:
+            json.dump(self.all, f, indent=1)
+
+    def forget(self):
+        """Drop the memory contents before they get overwritten.
+        has_chunk() still answers for the previous contents."""
+        self.previous = self.entry["chunks"]
+        self.entry["chunks"] = {}
+        self.save()
+
+    def has_chunk(self, addr: int, data):
+        return self.previous.get(f"{addr:05X}") == [
+            len(data),
+            binascii.crc32(data),
+        ]
+
+    def add_chunk(self, addr: int, data):
+        self.entry["chunks"][f"{addr:05X}"] = [len(data), binascii.crc32(data)]
+
+    def has_file(self, name, crc: int):
+        return self.entry["files"].get(name) == crc
+
+    def add_file(self, name, crc: int):
+        self.entry["files"][name] = crc
+
+
+class ROM:
+    """Virtual ROM aka The RP6502 ROM."""
+
+    def __init__(self):
+        """ROMs begin with up to a screen of help text"""
+        """ followed by a sparse array of virtual ROM. """
+        self.help = []
+        self.data = [0 for i in range(0x20000)]
+        self.alloc = [0 for i in range(0x20000)]
+
+    def add_help(self, string):
+        """Add help string."""
+        if len(string) > 80:
+            raise RuntimeError("Help line too long")
+        self.help.append(string)
+        if len(self.help) > 24:
+            raise RuntimeError("Help lines > 24")
+
+    def add_binary_data(self, data, addr: int):
+        """Add binary data."""
+        offset = 0
+        length = len(data)
+        self.allocate_rom(addr, length)
+        for i in range(length):
+            self.data[addr + i] = data[offset + i]
+
+    def add_irq_vector(self, addr: int):
+        """Set IRQ vector in $FFFE and $FFFF."""
+        if addr < 0 or addr > 0xFFFF:
+            raise RuntimeError(f"Invalid IRQ vector: ${addr:04X}")
+        self.allocate_rom(0xFFFE, 2)
+        self.data[0xFFFE] = addr & 0xFF
+        self.data[0xFFFF] = addr >> 8
+
+    def add_nmi_vector(self, addr: int):
+        """Set NMI vector in $FFFA and $FFFB."""
+        if addr < 0 or addr > 0xFFFF:
+            raise RuntimeError(f"Invalid NMI vector: ${addr:04X}")
+        self.allocate_rom(0xFFFA, 2)
+        self.data[0xFFFA] = addr & 0xFF
+        self.data[0xFFFB] = addr >> 8
+
+    def add_reset_vector(self, addr: int):
+        """Set reset vector in $FFFC and $FFFD."""
+        if addr < 0 or addr > 0xFFFF:
+            raise RuntimeError(f"Invalid reset vector: ${addr:04X}")
+        self.allocate_rom(0xFFFC, 2)
+        self.data[0xFFFC] = addr & 0xFF
+        self.data[0xFFFD] = addr >> 8
+
+    def add_binary_file(self, file, addr: Union[int, None] = None):
+        """Add binary memory data from file. addr=None uses"""
+        """first two bytes as address and second two bytes as reset."""
+        with open(file, "rb") as f:
+            data = f.read()
+        if addr == None:
+            if len(data) < 4:
+                raise RuntimeError("No addresses found.")
+            addr = data[0] + data[1] * 256
+            self.add_reset_vector(data[2] + data[3] * 256)
+            data = data[4:]
+        self.add_binary_data(data, addr)
+
+    def add_rp6502_file(self, file):
+        """Add RP6502 ROM data from file."""
+        with open(file, "rb") as f:
+            # Decode first line as cp850 because binary garbage can
+            # raise here before our better message gets to the user.
+            command = f.readline().decode("cp850")
+            if not re.match("^#![Rr][Pp]6502(\r|)\n$", command):
+                raise RuntimeError(f"Invalid RP6502 ROM file: {file}")
+            while True:
+                command = f.readline().decode("ascii").rstrip()
+                if len(command) == 0:
+                    break
+                se = re.search("^ *(# )", command)
+                if se:
+                    self.add_help(command[se.start(1) + 2 :])
+                    continue
+                if re.search("^ *#$", command):
+                    self.add_help("")
+                    continue
+                se = re.search("^ *([^ ]+) *([^ ]+) *([^ ]+) *$", command)
+                if se:
+
+                    def str_to_address(str):
+                        """Supports $FFFF number format."""
+                        if str:
+                            str = re.sub("^\\$", "0x", str)
+                        if re.match("^(0x|)[0-9A-Fa-f]*$", str):
+                            return eval(str)
+                        else:
+                            raise RuntimeError(f"Invalid address: {str}")
+
+                    addr = str_to_address(se.group(1))
+                    length = str_to_address(se.group(2))
+                    crc = str_to_address(se.group(3))
+                    self.allocate_rom(addr, length)
+                    data = f.read(length)
+                    if len(data) != length or crc != binascii.crc32(data):
+                        raise RuntimeError(f"Invalid CRC in block address: ${addr:04X}")
+                    for i in range(length):
+                        self.data[addr + i] = data[i]
+                    continue
+                raise RuntimeError(f"Corrupt RP6502 ROM file: {file}")
+
+    def allocate_rom(self, addr, length):
+        """Marks a range of memory as used. Raises on error."""
+        if (
+            (addr < 0x10000 and addr + length > 0x10000)
+            or addr + length > 0x20000
+            or addr < 0
+            or length < 0
+        ):
+            raise IndexError(
+                f"RP6502 invalid address ${addr+i:04X} or length ${length+i:03X}"
+            )
+        for i in range(length):
+            if self.alloc[addr + i]:
+                raise MemoryError(f"RP6502 ROM data already exists at ${addr+i:04X}")
+            self.alloc[addr + i] = 1
+
+    def has_reset_vector(self):
+        """Returns true if $FFFC and $FFFD have been set."""
+        return self.alloc[0xFFFC] and self.alloc[0xFFFD]
+
+    def next_rom_data(self, addr: int):
+        """Find next up-to-1k chunk starting at addr."""
+        for addr in range(addr, 0x20000):
+            if self.alloc[addr]:
+                length = 0
+                while self.alloc[addr + length]:
+                    length += 1
+                    if length == 1024 or addr + length == 0x10000:
+                        break
+                return addr, bytearray(self.data[addr : addr + length])
+        return None, None
+
+
+class Profile:
+    """Frame statistics the program prints on the console (see src/stats.h):
+       @F <mode> <frame ticks> <poses> <erase ticks>
+       @W <mode> <frames> <poses> <ticks> <erase ticks>
+       @G <mode> <level> <window ticks>
+       @M <mode> <level>"""
+
+    FRAME_FIELDS = ["mode", "ticks", "poses", "erase_ticks"]
+    WINDOW_FIELDS = ["mode", "frames", "poses", "ticks", "erase_ticks"]
+    GOVERNOR_FIELDS = ["mode", "level", "window_ticks"]
+    MANUAL_FIELDS = ["mode", "level"]
+    TICK_MS = 1000 / 60
+
+    def __init__(self):
+        self.frames = []
+        self.windows = []
+        self.governor = []
+        self.partial = b""
+
+    def add_line(self, line):
+        """Parse one console line. Returns False if it is not a stats line."""
+        se = re.match("^@([FWGM])((?: +[0-9]+)+) *$", line)
+        if not se:
+            return False
+        values = [int(v) for v in se.group(2).split()]
+        if se.group(1) == "F" and len(values) == len(self.FRAME_FIELDS):
+            self.frames.append(dict(zip(self.FRAME_FIELDS, values)))
+        elif se.group(1) == "W" and len(values) == len(self.WINDOW_FIELDS):
+            self.windows.append(dict(zip(self.WINDOW_FIELDS, values)))
+        elif se.group(1) == "G" and len(values) == len(self.GOVERNOR_FIELDS):
+            # the frames that follow were drawn at this level
+            self.governor.append(
+                dict(zip(self.GOVERNOR_FIELDS, values), frame=len(self.frames), manual=False)
+            )
+        elif se.group(1) == "M" and len(values) == len(self.MANUAL_FIELDS):
+            # [G] turned the governor on or off
+            self.governor.append(
+                dict(zip(self.MANUAL_FIELDS, values), window_ticks=0, frame=len(self.frames), manual=True)
+            )
+        else:
+            return False
+        return True
+
+    def add_data(self, data, end=False):
+        """Feed console bytes as they arrive. A line cut off by a read
+        timeout is kept until the rest comes in (or end). Returns the
+        lines that are not stats lines."""
+        lines = (self.partial + data).split(b"\n")
+        self.partial = b"" if end else lines.pop()
+        other = []
+        for line in lines:
+            text = line.decode("ascii", "replace").strip()
+            if text and not self.add_line(text):
+                other.append(text)
+        return other
+
+    def write(self, name):
+        """Per-frame records, JSON when name ends in .json, else CSV."""
+        if name.lower().endswith(".json"):
+            with open(name, "w") as f:
+                json.dump(
+                    {"frames": self.frames, "windows": self.windows, "governor": self.governor},
+                    f,
+                    indent=1,
+                )
+        else:
+            with open(name, "w") as f:
+                f.write("frame," + ",".join(self.FRAME_FIELDS) + "\n")
+                for i, frame in enumerate(self.frames):
+                    f.write(f"{i}," + ",".join(str(frame[k]) for k in self.FRAME_FIELDS) + "\n")
+
+    def summary(self):
+        """Frame time min/median/p99 per draw mode, in milliseconds."""
+
+        def percentile(values, p):
+            # nearest rank
+            return values[max(0, -(-len(values) * p // 100) - 1)]
+
+        lines = []
+        for mode in sorted(set(f["mode"] for f in self.frames)):
+            ticks = sorted(f["ticks"] for f in self.frames if f["mode"] == mode)
+            poses = sum(f["poses"] for f in self.frames if f["mode"] == mode)
+            lines.append(
+                f"mode {mode}: {len(ticks)} frames, {poses} poses, frame time "
+                f"min {ticks[0] * self.TICK_MS:.1f} ms, "
+                f"median {percentile(ticks, 50) * self.TICK_MS:.1f} ms, "
+                f"p99 {percentile(ticks, 99) * self.TICK_MS:.1f} ms"
+            )
+        if self.governor:
+            levels = [g["level"] for g in self.governor]
+            drops = restores = manual = 0
+            level = 0
+            for g in self.governor:
+                if g["manual"]:
+                    manual += 1
+                elif g["level"] > level:
+                    drops += 1
+                else:
+                    restores += 1
+                level = g["level"]
+            lines.append(
+                f"governor: {drops} drops, {restores} restores, {manual} set by hand, "
+                f"levels {min(levels)}..{max(levels)}, last {levels[-1]}"
+            )
+        return lines
+
+
+def exec_args():
+    # Give a hint at where the USB CDC mounts on various OSs
+    if platform.system() == "Windows":
+        default_device = "COM1"
+    elif platform.system() == "Darwin":
+        default_device = "/dev/tty.usbmodem"
+    elif platform.system() == "Linux":
+        default_device = "/dev/ttyACM0"
+    else:
+        default_device = "/dev/tty"
+
+    # Standard library argument parser
+    parser = argparse.ArgumentParser(
+        description="Interface with RP6502 RIA console via UART. Manage RP6502 ROM asset packaging."
+    )
+    parser.add_argument(
+        "command",
+        choices=["run", "upload", "create", "profile"],
+        help="Run local RP6502 ROM file by sending to RP6502 RAM. "
+        "Upload any local files to RP6502 USB MSC drive. "
+        "Create RP6502 ROM file from a local binary file and additional local ROM files. "
+        "Profile the running program from the stats lines on its console, "
+        "or from a recorded console stream given as filename. ",
+    )
+    parser.add_argument("filename", nargs="*", help="Local filename(s).")
+    parser.add_argument("-o", dest="out", metavar="name", help="Output path/filename.")
+    parser.add_argument(
+        "-c",
+        "--config",
+        dest="config",
+        metavar="name",
+        help=f"Configuration file for serial device.",
+    )
+    parser.add_argument(
+        "-D",
+        "--device",
+        dest="device",
+        metavar="dev",
+        default=default_device,
+        help=f"Serial device name. Default={default_device}",
+    )
+    parser.add_argument(
+        "-a",
+        "--address",
+        dest="address",
+        metavar="addr",
+        help="Starting address of file. If not provided, "
+        "the first two bytes of the file are the start address and "
+        "the second two bytes of the file are the reset vector.",
+    )
+    parser.add_argument("-i", "--irq", dest="irq", metavar="addr", help="IRQ vector.")
+    parser.add_argument("-n", "--nmi", dest="nmi", metavar="addr", help="NMI vector.")
+    parser.add_argument(
+        "-r", "--reset", dest="reset", metavar="addr", help="Reset vector."
+    )
+    parser.add_argument(
+        "-w",
+        "--window",
+        dest="window",
+        metavar="n",
+        type=int,
+        default=1,
+        help="Number of memory writes in flight before waiting for the monitor. Default=1",
+    )
+    parser.add_argument(
+        "-t",
+        "--time",
+        dest="time",
+        metavar="sec",
+        type=float,
+        help="Profile for this many seconds. Default is until Ctrl-C.",
+    )
+    parser.add_argument(
+        "--record",
+        dest="record",
+        metavar="name",
+        help="Save the console stream while profiling, for replaying later.",
+    )
+    parser.add_argument(
+        "--delta",
+        action="store_true",
+        help="Only send what changed since the last run or upload to this device: "
+        "files, and ROM chunks in the --read-only ranges.",
+    )
+    parser.add_argument(
+        "--read-only",
+        dest="read_only",
+        metavar="first-last",
+        action="append",
+        default=[],
+        help="ROM address range the program never writes, e.g. $1E100-$1FFFF "
+        "for XRAM assets. With --delta its unchanged chunks are not sent again. Repeatable.",
+    )
+    parser.add_argument(
+        "--manifest",
+        dest="manifest",
+        metavar="name",
+        default=".rp6502.manifest",
+        help="Record of the last run and upload. Default=.rp6502.manifest",
+    )
+    args = parser.parse_args()
+
+    # Standard library configuration parser
+    if args.config:
+        config = configparser.ConfigParser()
+        if not os.path.exists(args.config):
+            config["RP6502"] = {"device": args.device}
+            config.write(open(args.config, "w"))
+        else:
+            config.read(args.config)
+        if config.has_section("RP6502"):
+            args.device = config["RP6502"].get("device", args.device)
+
+    # Additional validation and conversion
+    def str_to_address(parser, str, errmsg):
+        """Supports $FFFF number format."""
+        if str:
+            str = re.sub("^\\$", "0x", str)
+            if re.match("^(0x|)[0-9A-Fa-f]*$", str):
+                return eval(str)
+            else:
+                parser.error(f"argument {errmsg}: invalid address: '{str}'")
+
+    args.address = str_to_address(parser, args.address, "-a/--address")
+    args.irq = str_to_address(parser, args.irq, "-i/--irq")
+    args.nmi = str_to_address(parser, args.nmi, "-n/--nmi")
+    args.reset = str_to_address(parser, args.reset, "-r/--reset")
+    read_only = []
+    for range_str in args.read_only:
+        bounds = range_str.split("-")
+        if len(bounds) != 2 or "" in bounds:
+            parser.error(f"argument --read-only: invalid range: '{range_str}'")
+        read_only.append(tuple(str_to_address(parser, b, "--read-only") for b in bounds))
+
+    # python3 tools/rp6502.py run
+    if args.command == "run":
+        print(f"[{os.path.basename(__file__)}] Loading ROM {args.filename[0]}")
+        rom = ROM()
+        rom.add_rp6502_file(args.filename[0])
+        if args.reset != None:
+            rom.add_reset_vector(args.reset)
+        manifest = Manifest(args.manifest, args.device)
+        print(f"[{os.path.basename(__file__)}] Opening device {args.device}")
+        mon = Monitor(args.device)
+        mon.send_break()
+        if args.delta and not read_only:
+            print(f"[{os.path.basename(__file__)}] No --read-only range, sending the whole ROM")
+        start = time.monotonic()
+        sent, skipped = mon.send_rom(rom, manifest, read_only if args.delta else (), max(1, args.window))
+        elapsed = time.monotonic() - start
+        manifest.save()
+        print(
+            f"[{os.path.basename(__file__)}] Sent {sent} bytes in {elapsed:.2f}s "
+            f"({sent / max(elapsed, 0.001):.0f} bytes/s)"
+        )
+        if args.delta:
+            print(f"[{os.path.basename(__file__)}] {skipped} unchanged bytes skipped")
+        if rom.has_reset_vector():
+            mon.reset()
+        else:
+            print("No reset vector. Not resetting.")
+
+    # python3 tools/rp6502.py upload
+    if args.command == "upload":
+        manifest = Manifest(args.manifest, args.device)
+        print(f"[{os.path.basename(__file__)}] Opening device {args.device}")
+        mon = Monitor(args.device)
+        if len(args.filename) > 0:
+            mon.send_break()
+        for file in args.filename:
+            with open(file, "rb") as f:
+                if len(args.filename) == 1 and args.out != None:
+                    dest = args.out
+                else:
+                    dest = os.path.basename(file)
+                crc = binascii.crc32(f.read())
+                if args.delta and manifest.has_file(dest, crc):
+                    print(f"[{os.path.basename(__file__)}] {file} unchanged, not uploading")
+                    continue
+                print(f"[{os.path.basename(__file__)}] Uploading {file}")
+                mon.upload(f, dest)
+                manifest.add_file(dest, crc)
+                manifest.save()
+
+    # python3 tools/rp6502.py profile
+    if args.command == "profile":
+        profile = Profile()
+        if len(args.filename) > 0:
+            for file in args.filename:
+                print(f"[{os.path.basename(__file__)}] Replaying {file}")
+                with open(file, "rb") as f:
+                    profile.add_data(f.read(), end=True)
+        else:
+            print(f"[{os.path.basename(__file__)}] Opening device {args.device}")
+            mon = Monitor(args.device)
+            record = open(args.record, "wb") if args.record else None
+            start = time.monotonic()
+            try:
+                while args.time == None or time.monotonic() - start < args.time:
+                    # may return part of a line when the read times out
+                    data = mon.serial.read_until()
+                    if record:
+                        record.write(data)
+                    for text in profile.add_data(data):
+                        print(text)
+            except KeyboardInterrupt:
+                pass
+            for text in profile.add_data(b"", end=True):
+                print(text)
+            if record:
+                record.close()
+        print(
+            f"[{os.path.basename(__file__)}] {len(profile.frames)} frames, "
+            f"{len(profile.windows)} windows"
+        )
+        for line in profile.summary():
+            print(line)
+        if args.out != None:
+            profile.write(args.out)
+
+    # python3 tools/rp6502.py create
+    if args.command == "create":
+        print(f"[{os.path.basename(__file__)}] Creating {args.out}")
+        rom = ROM()
+        if args.irq != None:
+            rom.add_irq_vector(args.irq)
+        if args.nmi != None:
+            rom.add_nmi_vector(args.nmi)
+        if args.reset != None:
+            rom.add_reset_vector(args.reset)
+        print(f"[{os.path.basename(__file__)}] Adding Binary Asset {args.filename[0]}")
+        rom.add_binary_file(args.filename[0], args.address)
+        for file in args.filename[1:]:
+            print(f"[{os.path.basename(__file__)}] Adding ROM Asset {file}")
+            rom.add_rp6502_file(file)
+        with open(args.out, "wb+") as file:
+            file.write(b"#!RP6502\n")
+            for help in rom.help:
+                file.write(bytes(f"# {help}\n", "ascii"))
+            addr, data = rom.next_rom_data(0)
+            while data != None:
+                file.write(
+                    bytes(
+                        f"${addr:04X} ${len(data):03X} ${binascii.crc32(data):08X}\n",
+                        "ascii",
+                    )
+                )
+                file.write(data)
+                addr += len(data)
+                addr, data = rom.next_rom_data(addr)
+
+
+# This file may be included or run like a program. e.g.
+#   import importlib
+#   rp6502 = importlib.import_module("tools.rp6502")
+if __name__ == "__main__":
+    exec_args()
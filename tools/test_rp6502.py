@@ -0,0 +1,274 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: Unlicense
+
+# Tests for rp6502.py against a stand-in for the RIA monitor on a pty,
+# and profile replays of testdata/profile.log (the console output of
+# src/stats.c and src/governor.c built for the host and driven through
+# light and heavy scenes, with [G] turned off and on once).
+#
+#   python3 tools/test_rp6502.py
+
+import os
+import sys
+import pty
+import time
+import tempfile
+import binascii
+import threading
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import rp6502
+
+
+class FakeMonitor:
+    """The part of the RIA monitor rp6502.py talks to: BINARY commands
+    with their data, and an empty line. Every command is answered with
+    the "]" prompt, or with a "?" error line first when the CRC does not
+    match or fail[addr] says how many more times that chunk fails.
+    reject[addr] fails the command line instead: like the real monitor,
+    its data is then read as commands, each an unknown one answered
+    after unknown_delay seconds."""
+
+    def __init__(self):
+        self.master, self.slave = pty.openpty()
+        self.name = os.ttyname(self.slave)
+        self.memory = bytearray(0x20000)
+        self.binaries = []  # (addr, length) of every BINARY accepted
+        self.errors = 0
+        self.fail = {}
+        self.reject = {}
+        self.unknown_delay = 0.0
+        self.running = True
+        self.thread = threading.Thread(target=self.serve, daemon=True)
+        self.thread.start()
+
+    def close(self):
+        self.running = False
+        os.close(self.master)
+        os.close(self.slave)
+
+    def read(self, count):
+        data = b""
+        while len(data) < count:
+            data += os.read(self.master, count - len(data))
+        return data
+
+    def read_line(self):
+        line = b""
+        while True:
+            c = self.read(1)
+            if c == b"\r":
+                return line.decode("latin-1")
+            line += c
+
+    def serve(self):
+        try:
+            while self.running:
+                line = self.read_line()
+                if line.startswith("BINARY "):
+                    addr, length, crc = (int(v[1:], 16) for v in line.split()[1:])
+                    if self.reject.get(addr, 0) > 0:
+                        self.reject[addr] -= 1
+                        self.errors += 1
+                        os.write(self.master, b"?invalid argument\r\n]")
+                        continue
+                    data = self.read(length)
+                    if self.fail.get(addr, 0) > 0:
+                        self.fail[addr] -= 1
+                        self.errors += 1
+                        os.write(self.master, b"?timeout\r\n]")
+                    elif binascii.crc32(data) != crc:
+                        self.errors += 1
+                        os.write(self.master, b"?CRC mismatch\r\n]")
+                    else:
+                        self.memory[addr : addr + length] = data
+                        self.binaries.append((addr, length))
+                        os.write(self.master, b"]")
+                elif line:
+                    time.sleep(self.unknown_delay)
+                    self.errors += 1
+                    os.write(self.master, b"?unknown command\r\n]")
+                else:
+                    os.write(self.master, b"]")
+        except OSError:
+            pass
+
+
+def make_rom(size, addr=0x0200, fill=None):
+    rom = rp6502.ROM()
+    rom.add_binary_data(bytes(fill or [i * 7 & 0xFF for i in range(size)]), addr)
+    return rom
+
+
+class MonitorTest(unittest.TestCase):
+    def setUp(self):
+        self.fake = FakeMonitor()
+        self.mon = rp6502.Monitor(self.fake.name)
+        self.dir = tempfile.TemporaryDirectory()
+        self.manifest_path = os.path.join(self.dir.name, "manifest")
+
+    def tearDown(self):
+        self.mon.serial.close()
+        self.fake.close()
+        self.dir.cleanup()
+
+    def manifest(self):
+        return rp6502.Manifest(self.manifest_path, self.fake.name)
+
+    def send(self, rom, read_only=(), window=1):
+        """Send like the run command: the manifest is saved once it is through."""
+        manifest = self.manifest()
+        result = self.mon.send_rom(rom, manifest, read_only, window)
+        manifest.save()
+        return result
+
+
+XRAM = [(0x10000, 0x1FFFF)]
+
+
+class DeltaTest(MonitorTest):
+    def test_full_run_sends_every_chunk(self):
+        rom = make_rom(4000)
+        sent, skipped = self.send(rom)
+        self.assertEqual((sent, skipped), (4000, 0))
+        self.assertEqual(len(self.fake.binaries), 4)
+        self.assertEqual(self.fake.memory[0x0200 : 0x0200 + 4000], bytes(rom.data[0x0200 : 0x0200 + 4000]))
+
+    def test_repeated_delta_sends_nothing(self):
+        self.send(make_rom(4000, 0x10200))
+        self.fake.binaries.clear()
+        sent, skipped = self.send(make_rom(4000, 0x10200), XRAM)
+        self.assertEqual((sent, skipped), (0, 4000))
+        self.assertEqual(self.fake.binaries, [])
+
+    def test_delta_sends_the_changed_chunk(self):
+        self.send(make_rom(4000, 0x10200))
+        self.fake.binaries.clear()
+        rom = make_rom(4000, 0x10200)
+        rom.data[0x10200 + 2500] ^= 0xFF
+        sent, skipped = self.send(rom, XRAM)
+        self.assertEqual(self.fake.binaries, [(0x10200 + 2048, 1024)])
+        self.assertEqual((sent, skipped), (1024, 2976))
+
+    def test_writable_memory_is_always_sent(self):
+        # the program may have changed its initialized data since
+        self.send(make_rom(4000))
+        self.fake.binaries.clear()
+        sent, skipped = self.send(make_rom(4000), XRAM)
+        self.assertEqual((sent, skipped), (4000, 0))
+        # a chunk that runs past the end of a range is not trusted either
+        self.send(make_rom(4000, 0x10200))
+        self.fake.binaries.clear()
+        sent, skipped = self.send(make_rom(4000, 0x10200), [(0x10200, 0x10200 + 2999)])
+        self.assertEqual(self.fake.binaries, [(0x10200 + 2048, 1024), (0x10200 + 3072, 928)])
+        self.assertEqual((sent, skipped), (1952, 2048))
+
+    def test_interrupted_send_is_not_trusted(self):
+        self.send(make_rom(4000, 0x10200))
+        manifest = self.manifest()
+        # the transfer stops before anything was recorded
+        manifest.forget()
+        self.fake.binaries.clear()
+        sent, skipped = self.send(make_rom(4000, 0x10200), XRAM)
+        self.assertEqual((sent, skipped), (4000, 0))
+
+
+class WindowTest(MonitorTest):
+    def test_window_sends_everything_in_order(self):
+        rom = make_rom(8000)
+        self.send(rom, window=4)
+        self.assertEqual([addr for addr, _ in self.fake.binaries], list(range(0x0200, 0x0200 + 8000, 1024)))
+        self.assertEqual(self.fake.memory[0x0200 : 0x0200 + 8000], bytes(rom.data[0x0200 : 0x0200 + 8000]))
+
+    def test_error_in_flight_resyncs_and_resends(self):
+        rom = make_rom(8000)
+        failed = 0x0200 + 2 * 1024
+        self.fake.fail[failed] = 1
+        self.send(rom, window=4)
+        self.assertEqual(self.fake.errors, 1)
+        # everything from the failed chunk on went again, the data is whole
+        addrs = [addr for addr, _ in self.fake.binaries]
+        self.assertEqual(addrs[-6:], list(range(failed, 0x0200 + 8000, 1024)))
+        self.assertEqual(self.fake.memory[0x0200 : 0x0200 + 8000], bytes(rom.data[0x0200 : 0x0200 + 8000]))
+
+    def test_data_of_a_rejected_command_is_waited_out(self):
+        rom = make_rom(8000)
+        failed = 0x0200 + 1024
+        self.fake.reject[failed] = 1
+        # slower than the 0.5 s a resync waits
+        self.fake.unknown_delay = 0.1
+        self.send(rom, window=4)
+        # the data of the rejected chunk and of the commands behind it
+        # ran as commands; none of that is taken for a failed resend
+        self.assertGreater(self.fake.errors, 1)
+        addrs = [addr for addr, _ in self.fake.binaries]
+        self.assertEqual(addrs.count(failed), 1)
+        self.assertEqual(addrs[-7:], list(range(failed, 0x0200 + 8000, 1024)))
+        self.assertEqual(self.fake.memory[0x0200 : 0x0200 + 8000], bytes(rom.data[0x0200 : 0x0200 + 8000]))
+
+    def test_error_that_persists_is_raised(self):
+        failed = 0x0200 + 1024
+        self.fake.fail[failed] = 100
+        with self.assertRaises(RuntimeError):
+            self.mon.binary_window([(0x0200 + i * 1024, bytes(1024)) for i in range(4)], window=2, retries=1)
+        # the first try and one retry
+        self.assertEqual(self.fake.errors, 2)
+
+
+PROFILE_LOG = os.path.join(os.path.dirname(os.path.abspath(__file__)), "testdata", "profile.log")
+
+
+class ProfileTest(unittest.TestCase):
+    def replay(self, piece=None):
+        profile = rp6502.Profile()
+        with open(PROFILE_LOG, "rb") as f:
+            data = f.read()
+        other = []
+        if piece is None:
+            other += profile.add_data(data, end=True)
+        else:
+            for i in range(0, len(data), piece):
+                other += profile.add_data(data[i : i + piece])
+            other += profile.add_data(b"", end=True)
+        return profile, other
+
+    def test_replay(self):
+        profile, other = self.replay()
+        self.assertEqual(len(profile.frames), 408)
+        self.assertEqual(len(profile.windows), 13)
+        self.assertEqual(other, ["Startup: 9 ticks"])
+        self.assertEqual(
+            profile.summary()[-1],
+            "governor: 7 drops, 3 restores, 2 set by hand, levels 0..3, last 1",
+        )
+
+    def test_lines_cut_by_read_timeouts(self):
+        whole, _ = self.replay()
+        for piece in (1, 7, 64):
+            cut, other = self.replay(piece)
+            self.assertEqual(cut.frames, whole.frames)
+            self.assertEqual(cut.windows, whole.windows)
+            self.assertEqual(cut.governor, whole.governor)
+            self.assertEqual(other, ["Startup: 9 ticks"])
+
+    def test_partial_line_is_one_sample(self):
+        profile = rp6502.Profile()
+        profile.add_data(b"@F 0 4 1 1\n@F 0 1")
+        self.assertEqual(len(profile.frames), 1)
+        profile.add_data(b"2 3 1\n")
+        self.assertEqual([f["ticks"] for f in profile.frames], [4, 12])
+
+    def test_manual_toggle_is_not_a_restore(self):
+        profile = rp6502.Profile()
+        for line in ["@G 0 1 72", "@G 0 2 48", "@M 0 0", "@M 0 0", "@G 0 1 72"]:
+            self.assertTrue(profile.add_line(line))
+        self.assertEqual(
+            profile.summary()[-1],
+            "governor: 3 drops, 0 restores, 2 set by hand, levels 0..2, last 1",
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()